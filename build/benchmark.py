@@ -1,6 +1,7 @@
 import subprocess
 import re
 import csv
+import json
 import logging
 
 # setup logger
@@ -16,6 +17,8 @@ console.setFormatter(formatter)
 logging.getLogger().addHandler(console)
 
 result_file_path = "results.csv"
+stage_result_file_path = "results_stages.csv"
+stage_fields = ["wallTime", "cpuTime", "bytesRead", "rowsIn", "rowsOut", "blocksScanned", "blocksSkipped"]
 
 block_sizes = [
     1000,
@@ -34,10 +37,21 @@ def extract_runtime(text):
     seconds = re.findall("Time measured: ([0-9]+.[0-9]+) seconds", text)
     return [float(x) for x in seconds]
 
-def run_query(workload, block_size, n):
+def extract_profiles(text):
+    return [json.loads(line) for line in text.splitlines() if line.startswith("{")]
+
+def write_stage_results(workload, block_size, run, profiles):
+    with open(stage_result_file_path,'a') as f:
+        csv_writer = csv.writer(f, delimiter=",")
+        for query, profile in enumerate(profiles):
+            for stage in profile["stages"]:
+                csv_writer.writerow([block_size, workload, run, query, profile["index"], stage["stage"]] + [stage[x] for x in stage_fields])
+
+def run_query(workload, block_size, n, profile=False):
     run_times = []
     for i in range(0,n):
-        result = subprocess.run(f"./sdcs {workload} {block_size}", shell=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        flags = " -p" if profile else ""
+        result = subprocess.run(f"./sdcs {workload} {block_size}{flags}", shell=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
         if result.returncode!=0:
             logging.error(f"return code {result.returncode}")
             break
@@ -46,6 +60,8 @@ def run_query(workload, block_size, n):
             break
         run_time = extract_runtime(result.stdout.decode('utf-8'))
         run_times.append(run_time)
+        if profile:
+            write_stage_results(workload, block_size, i, extract_profiles(result.stdout.decode('utf-8')))
     return run_times
 
 def get_median(run_times):
@@ -67,7 +83,10 @@ def write_results(row):
 if __name__=='__main__':
     with open(result_file_path,'w') as f:
         csv_writer = csv.writer(f, delimiter=",")
-        csv_writer.writerow(["w1'","w1''","w1'''","w2'","w2''","w2'''","w3'","w3''","w3'''","w4'","w4''","w4'''"])
+        csv_writer.writerow([f"w{w}-{index}" for w in range(1,5) for index in ["primary","columnPartition","qdTree","automatic"]])
+    with open(stage_result_file_path,'w') as f:
+        csv_writer = csv.writer(f, delimiter=",")
+        csv_writer.writerow(["block_size", "workload", "run", "query", "index", "stage"] + stage_fields)
 
     # tpch queries
     for block_size in block_sizes:
@@ -82,7 +101,11 @@ if __name__=='__main__':
             logging.info(f"benchmarking workload {workload} with block size {block_size}")
             results = run_query(workload, block_size, 10)
             logging.info(results)
-            for i in range(0,3):
+
+            # stage breakdown, profiled separately as printing the profiles is part of the measured time
+            logging.info(f"profiling workload {workload} with block size {block_size}")
+            run_query(workload, block_size, 1, profile=True)
+            for i in range(0,4):
                 median = get_median([x[i] for x in results])
                 run_times.append(median)
 
@@ -0,0 +1,112 @@
+#ifndef INCLUDE_BINARY_INDEX
+#define INCLUDE_BINARY_INDEX
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+#include "expression.h"
+
+namespace SDC{
+
+// block index in a binary format (.sdci), written next to the JSON index file and memory mapped.
+// Little endian, 8 byte aligned sections:
+//   header  magic "SDCI", format version, FNV-1a checksum of all bytes after the header,
+//           number of blocks and ranges, size of the string heap, table name
+//   blocks  per block: file path, number of rows (-1 if not stored), file size (-1 if the file was missing),
+//           first range and number of ranges
+//   ranges  per range: column, data type, flags (bounds present, inclusive), typed min and max
+//           (int64, double bits or a string of the heap), min and max as written in the JSON index
+//   heap    strings, referenced by offset and length
+class BinaryIndex {
+    public:
+        static constexpr uint32_t format_version = 1;
+
+        // maps the file, nullptr if it is missing, has another format version or a wrong checksum
+        static std::shared_ptr<const BinaryIndex> open(const std::string& path);
+
+        // writes a JSON index in the binary format
+        static void write(const json& index, const std::string& path);
+
+        // qd_index.json -> qd_index.sdci
+        static std::string binary_path(const std::string& json_path);
+
+        std::string_view table() const;
+        size_t num_blocks() const;
+        std::string_view file_path(size_t b) const;
+        int64_t num_rows(size_t b) const;
+        int64_t num_bytes(size_t b) const;
+        // range records of block b, pruning reads them in the mapped file
+        BlockRanges ranges(size_t b) const;
+        std::string_view range_column(uint64_t r) const;
+        // range record r with its bounds decoded, string bounds are copied
+        BlockRange range(uint64_t r) const;
+        // ranges of block b in the JSON index format
+        json ranges_json(size_t b) const;
+
+    private:
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint64_t checksum;
+            uint64_t num_blocks;
+            uint64_t num_ranges;
+            uint64_t heap_size;
+            uint32_t table_offset;
+            uint32_t table_length;
+        };
+
+        struct BlockRecord {
+            uint32_t path_offset;
+            uint32_t path_length;
+            int64_t num_rows;
+            int64_t num_bytes;
+            uint64_t first_range;
+            uint64_t num_ranges;
+        };
+
+        enum rangeFlags : uint8_t {
+            has_min = 1,
+            has_max = 2,
+            min_inclusive = 4,
+            max_inclusive = 8
+        };
+
+        struct RangeRecord {
+            uint32_t column_offset;
+            uint32_t column_length;
+            uint8_t type;
+            uint8_t flags;
+            uint8_t padding[6];
+            // int64 value, double bits, or heap offset << 32 | length of a string
+            uint64_t min;
+            uint64_t max;
+            uint32_t min_text_offset;
+            uint32_t min_text_length;
+            uint32_t max_text_offset;
+            uint32_t max_text_length;
+        };
+
+        BinaryIndex() = default;
+
+        std::shared_ptr<arrow::Buffer> _buffer;
+        const Header* _header;
+        const BlockRecord* _blocks;
+        const RangeRecord* _ranges;
+        const char* _heap;
+
+        std::string_view heap_string(uint32_t offset, uint32_t length) const;
+        Value decode_value(dataType type, uint64_t bits) const;
+        static uint64_t checksum(const uint8_t* data, size_t size);
+};
+
+}
+
+#endif // BINARY_INDEX
@@ -0,0 +1,48 @@
+#ifndef INCLUDE_BOOLEAN_MASK
+#define INCLUDE_BOOLEAN_MASK
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+
+namespace SDC{
+
+// boolean mask of a workload filter over all rows of a table, little endian:
+//   header   magic "SDCM", format version, encoding, number of rows, size of the payload
+//   payload  bitmap: the values in the Arrow bitmap layout (least significant bit first), memory mapped as is
+//            rle: uint64 lengths of alternating runs of false and true rows, starting with false
+// The smaller encoding is written. Masks written before the header existed (bitmap with the most significant
+// bit first, no header) are still read.
+class BooleanMaskFile {
+    public:
+        static constexpr uint32_t format_version = 1;
+
+        // writes the mask through a temporary file, run length encoded if that is smaller and allow_rle is set
+        static void write(const std::shared_ptr<arrow::Array>& mask, const std::string& path, bool allow_rle=true);
+
+        // BooleanArray of num_rows rows, the bitmap of a memory mapped file is not copied. nullptr if the file is missing
+        static std::shared_ptr<arrow::Array> read(const std::string& path, int64_t num_rows);
+
+    private:
+        enum encoding : uint8_t {
+            bitmap = 0,
+            rle = 1
+        };
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint8_t encoding;
+            uint8_t padding[7];
+            int64_t length;
+            uint64_t payload_size;
+        };
+
+        static std::shared_ptr<arrow::Array> read_legacy(const std::string& path, int64_t num_rows);
+};
+
+}
+
+#endif // BOOLEAN_MASK
@@ -0,0 +1,194 @@
+#ifndef INCLUDE_CATALOG
+#define INCLUDE_CATALOG
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+#include "expression.h"
+#include "types.h"
+#include "binary_index.h"
+#include "workload_log.h"
+
+namespace SDC{
+
+// index file with the paths, typed ranges and file sizes of its data blocks. Read from the binary index
+// if it is at least as new as the JSON index file, otherwise from the JSON index. A binary index is
+// queried in the mapped file, block paths and ranges view the index
+class PreparedIndex {
+    public:
+        std::string file_path;
+        std::string table;
+
+        size_t num_blocks() const;
+        std::string_view block_path(size_t b) const;
+        // -1 if the index does not store the number of rows of its blocks (primary index)
+        int64_t block_rows(size_t b) const;
+        int64_t block_bytes(size_t b) const;
+        BlockRanges block_ranges(size_t b) const;
+
+        // ranges of block b as written in the index file, for expressions and explain
+        json ranges_json(size_t b) const;
+
+    private:
+        friend class Catalog;
+        // JSON index, or the binary index it was read from
+        json _index;
+        std::shared_ptr<const BinaryIndex> _binary;
+        // blocks of a JSON index, the ranges of block b are _ranges[_first_range[b]] up to _ranges[_first_range[b+1]]
+        std::vector<int64_t> _block_rows;
+        std::vector<int64_t> _block_bytes;
+        std::vector<BlockRange> _ranges;
+        std::vector<size_t> _first_range;
+};
+
+// blocks of an index which a query scans, and for each of them whether all its rows match the query.
+// Pruning narrows a selection, starting from all blocks
+class BlockSelection {
+    public:
+        std::shared_ptr<const PreparedIndex> index;
+        std::vector<size_t> blocks;
+        std::vector<bool> fully_matching;
+
+        // every block of the index, not narrowed by any filter yet
+        static BlockSelection all_blocks(std::shared_ptr<const PreparedIndex> index);
+};
+
+// columns of a table by ordinal (position in the table metadata), with a hash map from name to ordinal
+class TableSchema {
+    public:
+        struct Column {
+            std::string name;
+            dataType type;
+            int ordinal;
+        };
+
+        TableSchema(const json& metadata_columns);
+
+        // nullptr for unknown columns
+        const Column* find(const std::string& name) const;
+
+        const std::vector<Column>& columns() const {
+            return _columns;
+        }
+
+        // field i is the column with ordinal i
+        const std::shared_ptr<arrow::Schema>& arrow_schema() const {
+            return _arrow_schema;
+        }
+
+    private:
+        std::vector<Column> _columns;
+        std::unordered_map<std::string, int> _ordinals;
+        std::shared_ptr<arrow::Schema> _arrow_schema;
+};
+
+// index entry of the table metadata
+class IndexMetadata {
+    public:
+        IndexMetadata(const json& metadata_index);
+
+        std::string type;
+        std::string file_path;
+        // blocks of primary and column partition indexes contain all columns, qd tree blocks only these
+        bool has_columns;
+        std::vector<std::string> columns;
+};
+
+// table entry of one version of metadata.json without the workload, queries read it through the catalog
+class TableMetadata {
+    public:
+        TableMetadata(json metadata);
+
+        // the entry as stored, rewritten by optimize
+        json metadata;
+        int64_t num_rows;
+        TableSchema schema;
+        std::vector<IndexMetadata> indexes;
+};
+
+// the table metadata and the workload entries a query looks up, taken from one refresh of the catalog so that
+// planning and executing a query reads the files once
+class WorkloadSnapshot {
+    public:
+        // nullptr if the table does not exist
+        std::shared_ptr<const TableMetadata> table;
+        // workload entry of the query, null if it was not recorded
+        json query;
+        // true and false count of the looked up filter keys which are recorded in the workload
+        std::unordered_map<std::string, std::pair<int64_t, int64_t>> filter_statistics;
+};
+
+// process wide cache of metadata.json and the index files. A file is parsed once and only parsed again
+// when its version (inode, size and modification time) changed, appended workload log records are
+// applied to the cached table without parsing metadata.json again.
+class Catalog {
+    public:
+        static Catalog& instance();
+
+        // table metadata, built once per version of metadata.json and shared by the queries. nullptr if the
+        // table does not exist
+        std::shared_ptr<const TableMetadata> table(const std::string& table_name, const std::string& data_directory);
+
+        // recorded queries of the table, with the workload log applied
+        json workload(const std::string& table_name, const std::string& data_directory);
+
+        // table metadata, workload entry of the query and statistics of the filter keys as of a single refresh
+        WorkloadSnapshot snapshot(const std::string& table_name, const std::string& data_directory, const std::string& query_id, const std::vector<std::string>& filter_keys);
+
+        // parsed index file of an index entry of the table metadata
+        std::shared_ptr<const PreparedIndex> index(const IndexMetadata& metadata_index);
+
+        // drops all cached files, called after metadata.json or index files were written
+        void invalidate();
+
+    private:
+        struct FileVersion {
+            bool exists = false;
+            uint64_t inode = 0;
+            int64_t size = 0;
+            int64_t modified = 0;
+
+            bool operator==(const FileVersion& other) const {
+                return exists==other.exists && inode==other.inode && size==other.size && modified==other.modified;
+            }
+        };
+
+        struct TableEntry {
+            FileVersion metadata_version;
+            FileVersion compacting_version;
+            // the log is replayed up to log_offset, it is truncated by a compaction if its inode changed
+            uint64_t log_inode = 0;
+            uint64_t log_offset = 0;
+            std::shared_ptr<const TableMetadata> table;
+            Workload workload;
+        };
+
+        struct IndexEntry {
+            FileVersion version;
+            FileVersion binary_version;
+            std::shared_ptr<const PreparedIndex> index;
+        };
+
+        std::mutex _mutex;
+        std::map<std::string, TableEntry> _tables;
+        std::map<std::string, IndexEntry> _indexes;
+
+        // entry of the table, parsed again if metadata.json or the log changed. Requires the shared metadata lock,
+        // the file and the catalog mutex
+        TableEntry& refresh(const std::string& table_name, const std::string& data_directory);
+        static FileVersion file_version(const std::string& path);
+        static std::shared_ptr<const PreparedIndex> parse_index(const std::string& file_path, bool use_binary);
+};
+
+}
+
+#endif // CATALOG
@@ -0,0 +1,168 @@
+#ifndef INCLUDE_EXPRESSION
+#define INCLUDE_EXPRESSION
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+#include "term.h"
+#include "types.h"
+
+namespace SDC{
+
+enum expressionType{
+    comparison,
+    and_,
+    or_,
+    not_,
+    in,
+    between,
+    derived
+};
+
+// name of the arrow compute function for a comparison operator
+std::string arrow_compute_operator(const std::string& filter_operator);
+
+// result of evaluating an expression on the value ranges of a data block
+enum rangeMatch{
+    never,
+    maybe,
+    always
+};
+
+class BinaryIndex;
+
+// value range of a column in a data block, as stored in the index. Bounds are typed,
+// exclusive bounds of integer, timestamp and date ranges are made inclusive.
+// The column views the index it was read from, which must outlive the range
+class BlockRange {
+    public:
+        BlockRange(const json& range);
+        BlockRange(std::string_view column, dataType type, bool has_min, Value min, bool min_inclusive, bool has_max, Value max, bool max_inclusive);
+
+        std::string_view column;
+        dataType type;
+        bool has_min;
+        bool has_max;
+        Value min;
+        Value max;
+        bool min_inclusive;
+        bool max_inclusive;
+
+        // never: no value of the range satisfies column operator_ constant, always: every value does.
+        // Bounds of another type than the constant give maybe
+        rangeMatch compare(const std::string& operator_, const Value& constant) const;
+
+    private:
+        void make_inclusive();
+};
+
+// value ranges of one data block: ranges decoded from a JSON index, or the range records of a memory mapped
+// binary index, which are decoded when accessed. Views the index, which must outlive it
+class BlockRanges {
+    public:
+        BlockRanges(const BlockRange* ranges, size_t size)
+        :_ranges(ranges), _size(size){};
+        BlockRanges(const BinaryIndex* binary, uint64_t first_range, size_t size)
+        :_binary(binary), _first_range(first_range), _size(size){};
+
+        size_t size() const {
+            return _size;
+        }
+
+        // column of range r, without decoding its bounds
+        std::string_view column(size_t r) const;
+        BlockRange operator[](size_t r) const;
+
+    private:
+        const BlockRange* _ranges = nullptr;
+        const BinaryIndex* _binary = nullptr;
+        uint64_t _first_range = 0;
+        size_t _size;
+};
+
+// predicate tree: comparisons (column op constant/column), comparisons of arithmetic terms, IN and BETWEEN as leaves,
+// combined with AND, OR and NOT
+class Expression {
+    public:
+        expressionType type;
+        std::string column;
+        std::string operator_;
+        // comparison: constant or column, in: value list, between: lower and upper bound (both inclusive)
+        std::vector<std::string> constants;
+        bool is_col = false;
+        // constants parsed as the column type, set by parse_constants
+        dataType column_type = dataType::double_;
+        std::vector<Value> values;
+        // derived: left and right term of the comparison
+        std::vector<Term> terms;
+        std::vector<Expression> children;
+
+        static Expression compare(std::string column, std::string operator_, std::string constant, bool is_col=false);
+        static Expression compare(Term lhs, std::string operator_, Term rhs);
+        static Expression is_in(std::string column, std::vector<std::string> values);
+        static Expression between(std::string column, std::string lower, std::string upper);
+        static Expression all_of(std::vector<Expression> children);
+        static Expression any_of(std::vector<Expression> children);
+        static Expression negate(Expression child);
+
+        // canonical text, used in the query id
+        std::string to_string() const;
+        json to_json() const;
+        void columns(std::vector<std::string>& result) const;
+        int num_leaves() const;
+
+        // parses the constants once into values and scalars of the column types, required before evaluate and evaluate_ranges
+        void parse_constants(const std::function<dataType(const std::string&)>& column_type);
+        // boolean mask over chunk i of the table, restricted to the selected rows if there is a selection
+        arrow::Result<std::shared_ptr<arrow::Array>> evaluate(const std::shared_ptr<arrow::Table>& table, int i, const std::shared_ptr<arrow::Array>& selection) const;
+        // never: no row of a block with these ranges can match, always: every row matches
+        rangeMatch evaluate_ranges(const BlockRanges& ranges) const;
+
+    private:
+        std::vector<std::shared_ptr<arrow::Scalar>> _scalars;
+        std::shared_ptr<arrow::Array> _value_set;
+        arrow::Result<arrow::Datum> column_chunk(const std::shared_ptr<arrow::Table>& table, const std::string& name, int i, const std::shared_ptr<arrow::Array>& selection) const;
+};
+
+// values of one column allowed by a conjunction of comparisons with constants. Bounds keep the type of the
+// column's constants, integer intervals are kept with inclusive integer bounds
+class Interval {
+    public:
+        Interval(std::string column, dataType type)
+        :column(column), type(type){};
+
+        std::string column;
+        dataType type;
+        bool has_min = false;
+        bool has_max = false;
+        Value min;
+        Value max;
+        bool min_inclusive = true;
+        bool max_inclusive = true;
+        // indexes of the filters merged into this interval
+        std::vector<size_t> filters;
+
+        // narrows the interval to the values satisfying column operator_ constant, false if operator_ is no range
+        bool intersect(const std::string& operator_, const Value& constant);
+        bool is_empty() const;
+        bool is_point(const Value& value) const;
+        std::string to_string() const;
+        // range check over chunk i of the table, restricted to the selected rows if there is a selection
+        arrow::Result<std::shared_ptr<arrow::Array>> evaluate(const std::shared_ptr<arrow::Table>& table, int i, const std::shared_ptr<arrow::Array>& selection) const;
+
+    private:
+        void set_min(const Value& value, bool inclusive);
+        void set_max(const Value& value, bool inclusive);
+};
+
+}
+
+#endif // EXPRESSION
@@ -14,12 +14,20 @@ class Filter{
         Filter() = default;
         Filter(std::string col, std::string op, std::string const_, bool is_col, dataType type)
         :column(col), operator_(op), constant_or_column(const_), is_col(is_col), type(type)
-        {}
+        {
+            // parse constants once, consumers use the typed value and scalar
+            if(!is_col){
+                value = parse_value(type, const_);
+                scalar = value_to_scalar(type, value);
+            }
+        }
 
         std::string column;
         std::string operator_;
         std::string constant_or_column;
         bool is_col;
+        Value value;
+        std::shared_ptr<arrow::Scalar> scalar;
         std::shared_ptr<arrow::Array> boolean_mask;
         dataType type;
         int true_count;
@@ -28,7 +36,7 @@ class Filter{
             return column==rhs.column && operator_==rhs.operator_ && type==rhs.type && is_col==rhs.is_col && constant_or_column==rhs.constant_or_column;
         }
         bool operator<(const Filter& rhs){
-            return column==rhs.column && is_col==rhs.is_col && is_col==rhs.is_col && constant_or_column<rhs.constant_or_column;
+            return column==rhs.column && is_col==rhs.is_col && value<rhs.value;
         }
 };
 
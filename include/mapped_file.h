@@ -0,0 +1,23 @@
+#ifndef INCLUDE_MAPPED_FILE
+#define INCLUDE_MAPPED_FILE
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <arrow/api.h>
+
+namespace SDC{
+
+// contents of a memory mapped file, nullptr if the file is missing or cannot be mapped.
+// The buffer references the mapped memory, the mapping lives as long as the buffer
+std::shared_ptr<arrow::Buffer> map_file(const std::string& path);
+
+// replaces the file with the concatenated parts: they are written to a uniquely named temporary file in the
+// same directory, synced and renamed over path, so readers never see a partially written file. The directory
+// is synced after the rename. False if the file could not be written
+bool write_file_atomically(const std::string& path, const std::vector<std::string_view>& parts);
+
+}
+
+#endif // MAPPED_FILE
@@ -0,0 +1,76 @@
+#ifndef INCLUDE_PROFILER
+#define INCLUDE_PROFILER
+
+#include <string>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+namespace SDC{
+
+enum queryStage{
+    metadata_load,
+    planning,
+    index_load,
+    pruning,
+    io,
+    decode,
+    filter,
+    projection,
+    update_metadata,
+    num_stages
+};
+
+std::string queryStage_to_string(queryStage s);
+
+class StageMetrics {
+    public:
+        double wall_time = 0;
+        double cpu_time = 0;
+        int64_t bytes_read = 0;
+        int64_t rows_in = 0;
+        int64_t rows_out = 0;
+        int64_t blocks_scanned = 0;
+        int64_t blocks_skipped = 0;
+        int64_t blocks_fully_matching = 0;
+};
+
+// per-stage breakdown of a single Dataframe::head call
+class QueryProfile {
+    public:
+        StageMetrics stages[queryStage::num_stages];
+
+        StageMetrics& operator[](queryStage s){
+            return stages[s];
+        }
+        void reset(){
+            for(auto& stage: stages){
+                stage = StageMetrics();
+            }
+        }
+        json to_json() const;
+};
+
+// accumulates wall and cpu time into a stage for the lifetime of the timer,
+// cpu time is process wide and therefore includes worker threads
+class StageTimer {
+    public:
+        StageTimer(StageMetrics& stage)
+        :stage(stage), wall_begin(std::chrono::steady_clock::now()), cpu_begin(std::clock()){};
+        ~StageTimer(){
+            auto wall_end = std::chrono::steady_clock::now();
+            stage.wall_time += std::chrono::duration<double>(wall_end - wall_begin).count();
+            stage.cpu_time += double(std::clock() - cpu_begin) / CLOCKS_PER_SEC;
+        }
+    private:
+        StageMetrics& stage;
+        std::chrono::steady_clock::time_point wall_begin;
+        std::clock_t cpu_begin;
+};
+
+}
+
+#endif // PROFILER
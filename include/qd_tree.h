@@ -22,9 +22,19 @@ class QDNodeRange {
         std::string max;
         bool max_inclusive;
         dataType col_data_type;
+        // typed bounds, only set if the bound is not empty
+        Value min_value;
+        Value max_value;
 
         QDNodeRange(std::string column, std::string min, bool min_inclusive, std::string max, bool max_inclusive, dataType col_data_type)
-        :column(column), min(min), max(max), col_data_type(col_data_type), min_inclusive(min_inclusive), max_inclusive(max_inclusive){};
+        :column(column), min(min), max(max), col_data_type(col_data_type), min_inclusive(min_inclusive), max_inclusive(max_inclusive){
+            if(min!=""){
+                min_value = parse_value(col_data_type, min);
+            }
+            if(max!=""){
+                max_value = parse_value(col_data_type, max);
+            }
+        };
 };
 
 class QDNode {
@@ -64,7 +74,7 @@ class QDNode {
 
 class QDTree {
     public:
-        QDTree(std::vector<Filter>& filters, std::vector<std::string>& projections, json& metadata, int leaf_min_size);
+        QDTree(std::vector<Filter>& filters, std::vector<std::vector<Filter>>& workload, std::vector<double>& workload_weights, std::vector<std::string>& projections, json& metadata, int leaf_min_size);
         
         std::vector<std::shared_ptr<QDNode>> leafNodes;
 
@@ -78,13 +88,19 @@ class QDTree {
         std::shared_ptr<QDNode> root;
     private:
 
+        // filters of every workload query, with parsed constants
+        std::vector<std::vector<Filter>> workload;
+
+        // decayed executions of every workload query, tuples discarded for a query are multiplied by its weight
+        std::vector<double> workload_weights;
+
         json metadata;
 
         int leaf_min_size;
 
         std::vector<QDNodeRange> add_range(std::vector<QDNodeRange> ranges, const Filter& filter, bool true_false_child);
 
-        bool make_cut(std::shared_ptr<QDNode>& node, std::vector<SDC::Filter> &filters, json& workload);
+        bool make_cut(std::shared_ptr<QDNode>& node, std::vector<SDC::Filter> &filters, std::vector<std::vector<Filter>>& workload);
 
         std::shared_ptr<arrow::Array> get_filter_mask(json& query_filter);
 };
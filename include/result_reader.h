@@ -0,0 +1,50 @@
+#ifndef INCLUDE_RESULT_READER
+#define INCLUDE_RESULT_READER
+
+#include <vector>
+#include <memory>
+#include <arrow/api.h>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+#include "catalog.h"
+
+namespace SDC{
+
+class Dataframe;
+
+// record batches of a query result, produced one data block at a time: a block is loaded, filtered
+// and projected when the batches of the previous block are consumed. Once the last batch is read the
+// filter statistics of all blocks are recorded in the workload, as by Dataframe::head.
+class ResultReader : public arrow::RecordBatchReader {
+    public:
+        // schema is only given for results without blocks, otherwise it is taken from the first selected block
+        ResultReader(Dataframe& dataframe, BlockSelection selection, std::shared_ptr<arrow::Schema> schema);
+
+        std::shared_ptr<arrow::Schema> schema() const override;
+        arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override;
+
+    private:
+        Dataframe& _dataframe;
+        BlockSelection _selection;
+        // position of the next block in the selection
+        size_t _next_block = 0;
+        bool _finished = false;
+        std::shared_ptr<arrow::Schema> _schema;
+        // result of the current block and its remaining batches
+        std::shared_ptr<arrow::Table> _table;
+        std::unique_ptr<arrow::TableBatchReader> _batches;
+        // filter statistics summed over the blocks
+        std::vector<int64_t> _true_counts;
+        std::vector<int64_t> _false_counts;
+        std::vector<arrow::ArrayVector> _boolean_masks;
+
+        // result of the next selected data block, nullptr after the last block
+        std::shared_ptr<arrow::Table> next_table();
+        void finish();
+};
+
+}
+
+#endif // RESULT_READER
@@ -18,39 +18,141 @@ using json = nlohmann::json;
 #include "qd_tree.h"
 #include "col_partition.h"
 #include "filter.h"
+#include "expression.h"
 #include "types.h"
+#include "profiler.h"
+#include "thread_pool.h"
+#include "result_reader.h"
+#include "workload_log.h"
+#include "catalog.h"
+#include "workload_summary.h"
+#include "boolean_mask.h"
 
 namespace SDC{
 
+// index used by head/explain, automatic picks the cheapest index which can answer the query
+enum indexType{
+    automatic,
+    primary,
+    columnPartition,
+    qdTree
+};
+
+// filters a block is pruned by: those of a query, or split for a prepared query into the constant filters and
+// expressions, checked once per index file version, and the parameters, checked at every execution
+enum filterSet{
+    all_filters,
+    constant_filters,
+    parameter_filters
+};
+
 class Dataframe {
     public:
-        Dataframe(std::string table, bool add_latency=false, bool verbose=false)
-        : _table_name(table), _add_latency(add_latency), _verbose(verbose), _data_directory("../data/"+table){};
-        void head(int use_index=1, int rows=0);
+        Dataframe(std::string table, bool add_latency=false, bool verbose=false, bool profiling=false)
+        : _data_directory("../data/"+table), _table_name(table), _verbose(verbose), _add_latency(add_latency), _profiling(profiling){};
+        void head(int use_index=indexType::automatic, int rows=0);
+        // streams the result, data blocks are loaded and filtered as the batches are read.
+        // The dataframe must outlive the reader.
+        std::shared_ptr<arrow::RecordBatchReader> scan(int use_index=indexType::automatic);
+        json profile();
+        json explain(int use_index=indexType::automatic, bool analyze=false);
+        // filters, parameters and expressions on a column which is not in the table throw std::invalid_argument
         void filter(std::string column, std::string operator_, std::string constant, bool is_col=false);
+        // filter comparing column with a constant which is bound before each execution of a prepared query
+        void parameter(std::string column, std::string operator_);
+        // conjunct with OR/NOT/IN/BETWEEN, comparisons and BETWEEN at the top level are added as plain filters
+        void filter(Expression expression);
         void projection(std::vector<std::string> projections);
+        // computed column, e.g. projection("tip_ratio", Term::col("tip_amount") / Term::col("fare_amount"))
+        void projection(std::string name, Term term);
         void group_by(std::string function_name);
         void optimize(std::string partition_column, int min_leaf_size);
+        // plans the query once: the metadata is loaded and the blocks of every index are pruned by the constant
+        // filters and expressions, so that executions only check the kept blocks against the bound parameters and
+        // scan. An index file rewritten since is pruned again. Prepare again after adding filters.
+        void prepare();
+        // constants of the parameters in the order they were added, throws std::invalid_argument if the number
+        // of constants differs. Executing a query with unbound parameters throws std::logic_error
+        void bind(std::vector<std::string> constants);
+        // fraction of qualifying rows below which a chunk's result is kept as selection vector instead of bitmap
+        void set_selection_vector_threshold(double threshold);
+        // optimize weighs workload queries by their executions, decayed with a half-life in days (0 disables the decay).
+        // Executions older than window days are ignored if window>0
+        void set_workload_decay(double half_life, double window=0);
+        // bounds the distinct filters and queries optimize builds the layout from, similar filters are merged
+        void set_workload_summary(size_t max_filters, size_t max_queries);
+        // boolean masks of a query on the primary index are recorded once, for the given fraction of query shapes
+        // or once a shape was executed min_executions times, 0 records them for the fraction only. They are
+        // written in the background
+        void set_workload_sampling(double fraction, int min_executions);
 
     private:
+        friend class ResultReader;
+
         std::string _data_directory;
         std::string _table_name;
         std::string _group_by;
         std::vector<Filter> _filters;
+        // positions of parameter filters in _filters
+        std::vector<size_t> _parameters;
+        bool _is_prepared = false;
+        // blocks of every index kept by the constant filters and expressions of a prepared query
+        std::vector<BlockSelection> _prepared_selections;
+        // blocks of the index chosen for the query which are scanned, set by plan_query
+        BlockSelection _selection;
+        std::vector<Expression> _expressions;
+        std::vector<Interval> _intervals;
+        bool _is_contradiction = false;
         std::vector<std::string> _projections;
+        std::vector<std::pair<std::string, Term>> _derived_projections;
         std::vector<std::string> _required_columns;
-        json _metadata;
+        // table metadata of the catalog, shared with other queries
+        std::shared_ptr<const TableMetadata> _table_metadata;
+        // workload entries of the query, taken once by plan_query and explain
+        WorkloadSnapshot _workload_snapshot;
         bool _using_primary_index;
         bool _verbose;
         bool _add_latency;
+        bool _profiling;
+        std::string _index_type;
+        json _index_selection;
+        QueryProfile _profile;
+        int64_t _morsel_size = 65536;
+        std::vector<bool> _fully_matching_chunks;
+        double _selection_vector_threshold = 0.05;
+        double _workload_half_life = 7;
+        double _workload_window = 0;
+        size_t _max_workload_filters = 64;
+        size_t _max_workload_queries = 1024;
+        double _mask_sample_fraction = 1;
+        int _mask_min_executions = 0;
+        // the execution evaluates and records the boolean masks of all filters, set by plan_query
+        bool _record_masks = false;
         void update_metadata();
-        json load_metadata();
-        json load_index(int use_index);
+        std::shared_ptr<const TableMetadata> load_metadata();
+        WorkloadSnapshot load_workload_snapshot();
+        void normalize_filters();
+        void check_parameters_bound();
+        std::shared_ptr<arrow::Table> empty_result();
+        bool plan_query(int use_index);
+        std::shared_ptr<arrow::Table> evaluate_query(std::shared_ptr<arrow::Table> table);
+        BlockSelection load_index(int use_index);
+        BlockSelection choose_index();
+        BlockSelection select_blocks(const IndexMetadata& metadata_index);
+        BlockSelection prune_blocks(const BlockSelection& selection, filterSet filters);
+        bool is_in_filter_set(size_t f, filterSet filters);
+        bool has_required_columns(const IndexMetadata& metadata_index);
+        int64_t block_num_rows(const PreparedIndex& index, size_t b);
         std::string get_query_id();
-        void write_boolean_filter(Filter& filter, const std::string& filepath);
-        std::shared_ptr<arrow::Array> read_boolean_filter(const std::string& filepath);
-        std::shared_ptr<arrow::Table> load_data(json index);
-        void remove_index(std::string index_type);
+        bool is_query_in_workload();
+        bool is_mask_sampled();
+        bool workload_filter_statistics(const Filter& filter, int64_t& true_count, int64_t& false_count);
+        std::shared_ptr<arrow::Table> load_data(const BlockSelection& selection);
+        std::shared_ptr<arrow::Table> load_block(const BlockSelection& selection, size_t s);
+        bool is_relevant_block(const PreparedIndex& index, size_t b, json* reason=nullptr, filterSet filters=filterSet::all_filters);
+        bool is_fully_matching_block(const PreparedIndex& index, size_t b, filterSet filters=filterSet::all_filters);
+        void remove_index(json& metadata, std::string index_type);
+        void write_index_file(const json& index_file, const std::string& file_path);
         json qdTree_metadata_file(QDTree qd, std::shared_ptr<arrow::Table> table);
         json metadata_qdTree_index(QDTree qd);
         json colPartition_metadata_file(ColPartition cp, std::shared_ptr<arrow::Table> table);
@@ -60,9 +162,13 @@ class Dataframe {
 
         // arrow & parquet
         std::shared_ptr<arrow::Table> load_parquet(std::string file_path);
+        std::shared_ptr<arrow::Table> split_morsels(const std::shared_ptr<arrow::Table>& table);
+        arrow::Result<std::shared_ptr<arrow::Array>> sparse_selection(const std::shared_ptr<arrow::Array>& mask);
         arrow::Status compute_filter_mask(std::shared_ptr<arrow::Table> table, std::vector<std::shared_ptr<arrow::Array>>& masks);
-        dataType get_col_dataType(std::string column);
+        dataType get_col_dataType(const std::string& column);
         std::string get_arrow_compute_operator(std::string filter_operator);
+        std::shared_ptr<arrow::Table> apply_projections(const std::shared_ptr<arrow::Table>& table, const std::vector<std::shared_ptr<arrow::Array>>& boolean_masks);
+        std::shared_ptr<arrow::Table> apply_derived_projections(const std::shared_ptr<arrow::Table>& table);
         std::shared_ptr<arrow::Table> apply_filters_projections(const std::shared_ptr<arrow::Table>& table, const std::vector<std::string>& projections, std::vector<std::shared_ptr<arrow::Array>> boolean_masks);
         arrow::Status write_parquet_file(const std::shared_ptr<arrow::Table>& table, const std::string& file_path);
 };
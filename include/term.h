@@ -0,0 +1,66 @@
+#ifndef INCLUDE_TERM
+#define INCLUDE_TERM
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+#include "types.h"
+
+namespace SDC{
+
+enum termType{
+    column_term,
+    constant_term,
+    add,
+    subtract,
+    multiply,
+    divide
+};
+
+class BlockRanges;
+
+// closed range of values a term can take, unbounded sides are infinite
+class Bounds {
+    public:
+        double min = -std::numeric_limits<double>::infinity();
+        double max = std::numeric_limits<double>::infinity();
+};
+
+// arithmetic over numeric columns and constants, e.g. tip_amount / fare_amount or fare_amount + tolls_amount.
+// Division always divides as floating point.
+class Term {
+    public:
+        termType type;
+        // column name or constant
+        std::string value;
+        // the constant, parsed once
+        double number = 0;
+        std::vector<Term> operands;
+
+        static Term col(std::string column);
+        static Term constant(std::string constant);
+
+        std::string to_string() const;
+        void columns(std::vector<std::string>& result) const;
+        int num_operations() const;
+
+        // values of the term over chunk i of the table, restricted to the selected rows if there is a selection
+        arrow::Result<arrow::Datum> evaluate(const std::shared_ptr<arrow::Table>& table, int i, const std::shared_ptr<arrow::Array>& selection) const;
+        // interval arithmetic over the column ranges of a data block
+        Bounds bounds(const BlockRanges& ranges) const;
+};
+
+Term operator+(const Term& lhs, const Term& rhs);
+Term operator-(const Term& lhs, const Term& rhs);
+Term operator*(const Term& lhs, const Term& rhs);
+Term operator/(const Term& lhs, const Term& rhs);
+
+}
+
+#endif // TERM
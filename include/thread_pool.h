@@ -0,0 +1,52 @@
+#ifndef INCLUDE_THREAD_POOL
+#define INCLUDE_THREAD_POOL
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace SDC{
+
+// process wide work-stealing pool: every worker owns a task queue, takes tasks from its own front
+// and steals from the back of other queues when it runs out of work
+class ThreadPool {
+    public:
+        ThreadPool(size_t num_threads);
+        ~ThreadPool();
+
+        // shared pool, sized by SDC_NUM_THREADS or the number of hardware threads
+        static ThreadPool& instance();
+
+        // runs task(0..n-1) on the pool, the calling thread helps until all tasks are finished
+        void parallel_for(size_t n, const std::function<void(size_t)>& task);
+
+        size_t size() const {
+            return workers.size();
+        }
+
+    private:
+        struct TaskQueue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<TaskQueue>> queues;
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::atomic<size_t> pending;
+        std::atomic<size_t> next_queue;
+        bool stop;
+
+        bool run_task(size_t queue_id);
+        void worker_loop(size_t id);
+};
+
+}
+
+#endif // THREAD_POOL
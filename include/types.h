@@ -2,18 +2,55 @@
 #define INCLUDE_TYPES
 
 #include <iostream>
+#include <string>
+#include <variant>
+#include <memory>
+#include <functional>
+#include <arrow/api.h>
 
 namespace SDC{
 
 enum dataType{
     int64,
-    double_
+    double_,
+    timestamp,
+    date,
+    string,
+    int32,
+    int8
 };
 
 std::string dataType_to_string(dataType d);
 
 dataType string_to_dataType(std::string d);
 
+// data type of a column in the table metadata, e.g. "int64", "timestamp", "string"
+dataType column_dataType(const std::string& d);
+
+std::shared_ptr<arrow::DataType> dataType_to_arrow(dataType d);
+
+// integer types, timestamps and dates have a smallest step between values, exclusive bounds can be made inclusive
+bool is_integer_type(dataType d);
+
+// parsed filter constant, values of the same column share the alternative and compare naturally.
+// Integers of every width are int64_t, timestamps are microseconds and dates days since epoch.
+using Value = std::variant<int64_t, double, std::string>;
+
+// timestamps and dates are parsed from ISO 8601, e.g. "2022-07-01 08:30:00" and "2022-07-01"
+Value parse_value(dataType type, const std::string& value);
+
+std::shared_ptr<arrow::Scalar> value_to_scalar(dataType type, const Value& value);
+
+// numeric value for interval reasoning, NaN for strings
+double value_to_double(const Value& value);
+
+// dictionary encoded columns are compared on their decoded values
+arrow::Result<arrow::Datum> decode_dictionary(const arrow::Datum& values);
+
+// evaluates the predicate once per dictionary entry of dictionary encoded values and gathers the
+// result through the indices, other values are evaluated directly
+arrow::Result<arrow::Datum> evaluate_encoded(const arrow::Datum& values, const std::function<arrow::Result<arrow::Datum>(const arrow::Datum&)>& predicate);
+
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,132 @@
+#ifndef INCLUDE_WORKLOAD_LOG
+#define INCLUDE_WORKLOAD_LOG
+
+#include <string>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <functional>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+namespace SDC{
+
+// workload of a table with hash indexes on the query fingerprints and on the recorded filters
+class Workload {
+    public:
+        Workload(const json& queries=json::array());
+
+        // applies a record: increments the execution count of a known query, adds a new query.
+        // The execution is counted on the day of its executedAt timestamp (seconds since epoch).
+        // A record with booleanMasks (filter key -> mask file) attaches the masks to the filters of the query
+        void apply(const json& record);
+
+        bool contains(const std::string& query_id) const;
+
+        // workload entry of the query, nullptr if it was not recorded
+        const json* query(const std::string& query_id) const;
+
+        // true and false count of the filter in the first recorded query using it
+        bool filter_statistics(const std::string& filter_key, int64_t& true_count, int64_t& false_count) const;
+
+        static std::string filter_key(const std::string& column, const std::string& operator_, const std::string& constant_or_column, bool is_col);
+
+        // executions of the query, each decayed by 0.5^(age/half_life) where age is in days. Executions older than
+        // window days are left out if window>0, half_life 0 disables the decay. Executions recorded without a
+        // timestamp are decayed like the oldest recorded day.
+        static double weight(const json& query, int64_t now, double half_life, double window);
+
+        const json& queries() const {
+            return _queries;
+        }
+
+    private:
+        json _queries;
+        std::unordered_map<std::string, size_t> _query_positions;
+        std::unordered_map<std::string, std::pair<int64_t, int64_t>> _filter_statistics;
+
+        void add_to_index(size_t position);
+        static void add_execution_day(json& query, const json& record);
+};
+
+// advisory lock (flock) on a lock file, held until destruction. Serializes processes and threads
+// which open the lock file themselves, the lock file is created if missing
+class FileLock {
+    public:
+        FileLock(const std::string& path, bool shared=false);
+        ~FileLock();
+        FileLock(const FileLock&) = delete;
+        FileLock& operator=(const FileLock&) = delete;
+
+    private:
+        int _fd;
+};
+
+// append-only log of query executions of a table, one length-prefixed msgpack record per execution:
+// a repeated query only logs its queryID, a new query logs its complete workload entry.
+// compaction folds the log into the workload of the table in metadata.json and truncates it.
+// Concurrent appends of a process are group committed: one thread writes the records of all waiting
+// threads with a single write. Between processes, metadata.json.lock guards metadata.json (exclusive
+// for writers, shared for readers) and workload.log.lock guards appends against the rename of the log.
+// Locks are taken in the order metadata lock, file mutex, log lock.
+class WorkloadLog {
+    public:
+        WorkloadLog(const std::string& table_name, const std::string& data_directory);
+
+        // appends the record of one execution and returns once it is written and synced, starts a background compaction
+        // once the log outgrows compaction_bytes
+        void append(const json& record);
+
+        // runs task on the background recorder thread and appends the boolean mask record it returns unless it is
+        // null, for recording work the query does not wait for. The masks of the query are pending until the record
+        // is appended, returns false without scheduling the task if they already are
+        bool append_masks_deferred(const std::string& query_id, std::function<json()> task);
+
+        // the boolean masks of the query are scheduled by this process and not yet appended
+        bool masks_pending(const std::string& query_id) const;
+
+        // waits until all deferred records are appended
+        static void flush();
+
+        // folds the log into metadata.json, waits for deferred records and a running background compaction
+        void compact();
+
+        // applies the records of a log file from offset on, returns the offset after the last complete record
+        static uint64_t read_records(const std::string& path, Workload& workload, uint64_t offset=0);
+
+        // guards metadata.json and the logs of all tables within the process
+        static std::mutex& file_mutex();
+
+        static std::string metadata_lock_path(){
+            return "../data/metadata.json.lock";
+        }
+
+        // replaces metadata.json with a rename of a synced temporary file, requires the exclusive metadata lock.
+        // False if it could not be written, metadata.json is then unchanged
+        static bool write_metadata(const json& metadata_json);
+
+        const std::string& log_path() const {
+            return _log_path;
+        }
+
+        const std::string& compacting_path() const {
+            return _compacting_path;
+        }
+
+        static constexpr uintmax_t compaction_bytes = 1 << 16;
+
+    private:
+        std::string _table_name;
+        std::string _log_path;
+        // log renamed away by a running compaction, new records go to a fresh log meanwhile
+        std::string _compacting_path;
+        std::string _lock_path;
+
+        static void compact_files(const std::string& table_name, const std::string& log_path, const std::string& compacting_path, const std::string& lock_path);
+};
+
+}
+
+#endif // WORKLOAD_LOG
@@ -0,0 +1,50 @@
+#ifndef INCLUDE_WORKLOAD_SUMMARY
+#define INCLUDE_WORKLOAD_SUMMARY
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+namespace SDC{
+
+// bounded input for optimize: the distinct filters of the workload are clustered per column and operator
+// direction (<,<= and >,>=) by their selectivity, each cluster is replaced by a representative filter, preferably
+// one with a boolean mask. Queries which are equal after the replacement are merged and their weights added up.
+// Equality, inequality and column comparisons are not clustered, only the heaviest of them are kept.
+//
+// The error of replacing a filter is the fraction of rows whose outcome changes: for ranges on the same column
+// and direction the difference of the selectivities, for a dropped filter the fraction of rows it discarded.
+// A range cluster without any boolean mask has no cut candidate, its filters count as dropped.
+class WorkloadSummary {
+    public:
+        struct Query {
+            // workload filters (column, operator, constantOrColumn, isCol, counts, boolean mask)
+            std::vector<json> filters;
+            double weight;
+        };
+
+        // workload entries and their weights, at most max_filters distinct filters (at least one per column
+        // and operator direction) and max_queries queries, the lightest queries are dropped
+        WorkloadSummary(const json& workload, const std::vector<double>& weights, size_t max_filters, size_t max_queries);
+
+        const std::vector<Query>& queries() const {
+            return _queries;
+        }
+
+        // number of queries and filters before and after, weighted mean and maximum row error of the
+        // replaced filters and the fraction of the query weight which was dropped
+        const json& report() const {
+            return _report;
+        }
+
+    private:
+        std::vector<Query> _queries;
+        json _report;
+};
+
+}
+
+#endif // WORKLOAD_SUMMARY
@@ -0,0 +1,215 @@
+#include "binary_index.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+#include <unordered_map>
+
+namespace SDC{
+
+std::string BinaryIndex::binary_path(const std::string& json_path){
+    std::filesystem::path path(json_path);
+    return path.replace_extension(".sdci").string();
+}
+
+// FNV-1a
+uint64_t BinaryIndex::checksum(const uint8_t* data, size_t size){
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i=0; i<size; i++){
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void BinaryIndex::write(const json& index, const std::string& path){
+    std::string heap;
+    std::unordered_map<std::string, uint32_t> heap_offsets;
+    auto add_string = [&heap, &heap_offsets](const std::string& value) -> uint32_t {
+        auto it = heap_offsets.find(value);
+        if(it!=heap_offsets.end()){
+            return it->second;
+        }
+        uint32_t offset = heap.size();
+        heap += value;
+        heap_offsets[value] = offset;
+        return offset;
+    };
+    auto encode_value = [&add_string](dataType type, const Value& value) -> uint64_t {
+        switch(type){
+            case dataType::double_:{
+                double d = std::get<double>(value);
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                return bits;
+            }
+            case dataType::string:{
+                const std::string& s = std::get<std::string>(value);
+                return uint64_t(add_string(s)) << 32 | s.size();
+            }
+            default:
+                return uint64_t(std::get<int64_t>(value));
+        }
+    };
+
+    std::vector<BlockRecord> blocks;
+    std::vector<RangeRecord> ranges;
+    for(const auto& block: index["dataBlocks"]){
+        std::string file_path = block["filePath"];
+        BlockRecord block_record{};
+        block_record.path_offset = add_string(file_path);
+        block_record.path_length = file_path.size();
+        block_record.num_rows = block.value("numRows", int64_t(-1));
+        block_record.num_bytes = std::filesystem::exists(file_path) ? int64_t(std::filesystem::file_size(file_path)) : -1;
+        block_record.first_range = ranges.size();
+        for(const auto& range: block.value("ranges", json::array())){
+            std::string column = range["column"];
+            std::string min = range["min"];
+            std::string max = range["max"];
+            dataType type = string_to_dataType(range["colDataType"]);
+            RangeRecord range_record{};
+            range_record.column_offset = add_string(column);
+            range_record.column_length = column.size();
+            range_record.type = type;
+            range_record.flags = (min!="" ? has_min : 0) | (max!="" ? has_max : 0)
+                | (range["minInclusive"] ? min_inclusive : 0) | (range["maxInclusive"] ? max_inclusive : 0);
+            if(min!=""){
+                range_record.min = encode_value(type, parse_value(type, min));
+            }
+            if(max!=""){
+                range_record.max = encode_value(type, parse_value(type, max));
+            }
+            range_record.min_text_offset = add_string(min);
+            range_record.min_text_length = min.size();
+            range_record.max_text_offset = add_string(max);
+            range_record.max_text_length = max.size();
+            ranges.push_back(range_record);
+        }
+        block_record.num_ranges = ranges.size() - block_record.first_range;
+        blocks.push_back(block_record);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, "SDCI", 4);
+    header.version = format_version;
+    header.num_blocks = blocks.size();
+    header.num_ranges = ranges.size();
+    std::string table = index.value("table", "");
+    header.table_offset = add_string(table);
+    header.table_length = table.size();
+    heap.resize((heap.size()+7)/8*8, '\0');
+    header.heap_size = heap.size();
+
+    std::string payload;
+    payload.append(reinterpret_cast<const char*>(blocks.data()), blocks.size()*sizeof(BlockRecord));
+    payload.append(reinterpret_cast<const char*>(ranges.data()), ranges.size()*sizeof(RangeRecord));
+    payload.append(heap);
+    header.checksum = checksum(reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+
+    if(!write_file_atomically(path, {std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)), payload})){
+        std::cout << "binary index " << path << " could not be written" << std::endl;
+    }
+}
+
+std::shared_ptr<const BinaryIndex> BinaryIndex::open(const std::string& path){
+    std::shared_ptr<arrow::Buffer> buffer = map_file(path);
+    if(buffer==nullptr){
+        return nullptr;
+    }
+    int64_t size = buffer->size();
+    if(size<int64_t(sizeof(Header))){
+        std::cout << "binary index " << path << " is corrupt" << std::endl;
+        return nullptr;
+    }
+    const Header* header = reinterpret_cast<const Header*>(buffer->data());
+    if(std::memcmp(header->magic, "SDCI", 4)!=0 || header->version!=format_version){
+        std::cout << "binary index " << path << " has an unknown format" << std::endl;
+        return nullptr;
+    }
+    int64_t expected_size = sizeof(Header) + header->num_blocks*sizeof(BlockRecord) + header->num_ranges*sizeof(RangeRecord) + header->heap_size;
+    if(size!=expected_size || checksum(buffer->data()+sizeof(Header), size-sizeof(Header))!=header->checksum){
+        std::cout << "binary index " << path << " is corrupt" << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<BinaryIndex> index(new BinaryIndex());
+    index->_buffer = buffer;
+    index->_header = header;
+    index->_blocks = reinterpret_cast<const BlockRecord*>(buffer->data()+sizeof(Header));
+    index->_ranges = reinterpret_cast<const RangeRecord*>(index->_blocks+header->num_blocks);
+    index->_heap = reinterpret_cast<const char*>(index->_ranges+header->num_ranges);
+    return index;
+}
+
+std::string_view BinaryIndex::heap_string(uint32_t offset, uint32_t length) const {
+    return std::string_view(_heap+offset, length);
+}
+
+Value BinaryIndex::decode_value(dataType type, uint64_t bits) const {
+    switch(type){
+        case dataType::double_:{
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            return d;
+        }
+        case dataType::string:
+            return std::string(heap_string(bits >> 32, bits & 0xffffffff));
+        default:
+            return int64_t(bits);
+    }
+}
+
+std::string_view BinaryIndex::table() const {
+    return heap_string(_header->table_offset, _header->table_length);
+}
+
+size_t BinaryIndex::num_blocks() const {
+    return _header->num_blocks;
+}
+
+std::string_view BinaryIndex::file_path(size_t b) const {
+    return heap_string(_blocks[b].path_offset, _blocks[b].path_length);
+}
+
+int64_t BinaryIndex::num_rows(size_t b) const {
+    return _blocks[b].num_rows;
+}
+
+int64_t BinaryIndex::num_bytes(size_t b) const {
+    return _blocks[b].num_bytes;
+}
+
+BlockRanges BinaryIndex::ranges(size_t b) const {
+    return BlockRanges(this, _blocks[b].first_range, _blocks[b].num_ranges);
+}
+
+std::string_view BinaryIndex::range_column(uint64_t r) const {
+    return heap_string(_ranges[r].column_offset, _ranges[r].column_length);
+}
+
+BlockRange BinaryIndex::range(uint64_t r) const {
+    const RangeRecord& range = _ranges[r];
+    dataType type = dataType(range.type);
+    return BlockRange(range_column(r), type,
+        range.flags & has_min, decode_value(type, range.min), range.flags & min_inclusive,
+        range.flags & has_max, decode_value(type, range.max), range.flags & max_inclusive);
+}
+
+json BinaryIndex::ranges_json(size_t b) const {
+    json result = json::array();
+    for(uint64_t r=_blocks[b].first_range; r<_blocks[b].first_range+_blocks[b].num_ranges; r++){
+        const RangeRecord& range = _ranges[r];
+        json json_range;
+        json_range["column"] = heap_string(range.column_offset, range.column_length);
+        json_range["min"] = heap_string(range.min_text_offset, range.min_text_length);
+        json_range["minInclusive"] = bool(range.flags & min_inclusive);
+        json_range["max"] = heap_string(range.max_text_offset, range.max_text_length);
+        json_range["maxInclusive"] = bool(range.flags & max_inclusive);
+        json_range["colDataType"] = dataType_to_string(dataType(range.type));
+        result.push_back(json_range);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,158 @@
+#include "boolean_mask.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <cassert>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+namespace SDC{
+
+static bool get_bit(const uint8_t* bits, int64_t i){
+    return (bits[i >> 3] >> (i & 7)) & 1;
+}
+
+// sets bits [begin, begin+length) of a zeroed bitmap, whole bytes at once
+static void set_bits(uint8_t* bits, int64_t begin, int64_t length){
+    int64_t end = begin + length;
+    while(begin<end && (begin & 7)!=0){
+        bits[begin >> 3] |= 1 << (begin & 7);
+        begin++;
+    }
+    int64_t num_bytes = (end - begin) >> 3;
+    std::memset(bits + (begin >> 3), 0xFF, num_bytes);
+    begin += num_bytes << 3;
+    while(begin<end){
+        bits[begin >> 3] |= 1 << (begin & 7);
+        begin++;
+    }
+}
+
+void BooleanMaskFile::write(const std::shared_ptr<arrow::Array>& mask, const std::string& path, bool allow_rle){
+    const auto& array = std::static_pointer_cast<arrow::BooleanArray>(mask);
+    int64_t length = array->length();
+    int64_t offset = array->offset();
+    const uint8_t* values = array->values()->data();
+
+    // bitmap starting at bit 0, masks concatenated from chunks usually have no offset
+    std::vector<uint8_t> bitmap_bytes;
+    const uint8_t* bitmap_data = values + (offset >> 3);
+    if((offset & 7)!=0){
+        bitmap_bytes.resize((length+7)/8, 0);
+        for(int64_t i=0; i<length; i++){
+            if(get_bit(values, offset+i)){
+                bitmap_bytes[i >> 3] |= 1 << (i & 7);
+            }
+        }
+        bitmap_data = bitmap_bytes.data();
+    }
+    uint64_t bitmap_size = (length+7)/8;
+
+    // runs of equal bits, bytes of only false or only true rows are skipped at once
+    std::vector<uint64_t> runs;
+    if(allow_rle){
+        bool value = false;
+        uint64_t run = 0;
+        int64_t i = 0;
+        while(i<length && runs.size()*sizeof(uint64_t)<bitmap_size){
+            if((i & 7)==0 && i+8<=length && bitmap_data[i >> 3]==(value ? 0xFF : 0x00)){
+                run += 8;
+                i += 8;
+                continue;
+            }
+            if(get_bit(bitmap_data, i)!=value){
+                runs.push_back(run);
+                run = 0;
+                value = !value;
+            }
+            run++;
+            i++;
+        }
+        runs.push_back(run);
+    }
+    bool use_rle = allow_rle && runs.size()*sizeof(uint64_t)<bitmap_size;
+
+    Header header{};
+    std::memcpy(header.magic, "SDCM", 4);
+    header.version = format_version;
+    header.encoding = use_rle ? encoding::rle : encoding::bitmap;
+    header.length = length;
+    header.payload_size = use_rle ? runs.size()*sizeof(uint64_t) : bitmap_size;
+
+    std::string_view payload = use_rle ? std::string_view(reinterpret_cast<const char*>(runs.data()), header.payload_size)
+        : std::string_view(reinterpret_cast<const char*>(bitmap_data), bitmap_size);
+    if(!write_file_atomically(path, {std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)), payload})){
+        std::cerr << "Failed to write " << path << std::endl;
+    }
+}
+
+std::shared_ptr<arrow::Array> BooleanMaskFile::read(const std::string& path, int64_t num_rows){
+    std::shared_ptr<arrow::Buffer> buffer = map_file(path);
+    if(buffer==nullptr){
+        std::cerr << "Failed to open " << path << std::endl;
+        return nullptr;
+    }
+    int64_t size = buffer->size();
+    if(size<int64_t(sizeof(Header))){
+        return read_legacy(path, num_rows);
+    }
+    const Header* header = reinterpret_cast<const Header*>(buffer->data());
+    if(std::memcmp(header->magic, "SDCM", 4)!=0 || header->version!=format_version || size!=int64_t(sizeof(Header)+header->payload_size)){
+        return read_legacy(path, num_rows);
+    }
+    assert(header->length==num_rows);
+
+    if(header->encoding==encoding::bitmap){
+        assert(header->payload_size==uint64_t((num_rows+7)/8));
+        std::shared_ptr<arrow::Buffer> values = arrow::SliceBuffer(buffer, sizeof(Header), header->payload_size);
+        return std::make_shared<arrow::BooleanArray>(num_rows, values);
+    }
+
+    const uint64_t* runs = reinterpret_cast<const uint64_t*>(buffer->data()+sizeof(Header));
+    size_t num_runs = header->payload_size/sizeof(uint64_t);
+    std::shared_ptr<arrow::Buffer> values = arrow::AllocateBuffer((num_rows+7)/8).ValueOrDie();
+    uint8_t* bits = values->mutable_data();
+    std::memset(bits, 0, values->size());
+    int64_t position = 0;
+    for(size_t r=0; r<num_runs; r++){
+        // odd runs are true
+        if(r%2==1){
+            set_bits(bits, position, runs[r]);
+        }
+        position += runs[r];
+    }
+    assert(position==num_rows);
+    return std::make_shared<arrow::BooleanArray>(num_rows, values);
+}
+
+// bitmap with the most significant bit first and without a header
+std::shared_ptr<arrow::Array> BooleanMaskFile::read_legacy(const std::string& path, int64_t num_rows){
+    std::ifstream in_file;
+    std::shared_ptr<arrow::Array> boolean_filter;
+    auto builder = arrow::BooleanBuilder();
+    in_file.open(path, in_file.binary);
+    if(!in_file.is_open()){
+        std::cerr << "Failed to open " << path << std::endl;
+    }
+    else{
+        int64_t bit_counter = 0;
+        while(in_file.peek()!=EOF){
+            char ch;
+            in_file.read(&ch, sizeof(ch));
+            for (int i=0; i<8; i++){
+                if(bit_counter<num_rows){
+                    bool bit = (ch >> (8-1-i)) & 1U;
+                    arrow::Status a = builder.Append(bit);
+                    bit_counter++;
+                }
+            }
+        }
+    }
+    auto st = builder.Finish(&boolean_filter);
+    assert(st.ok());
+
+    return boolean_filter;
+}
+
+}
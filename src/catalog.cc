@@ -0,0 +1,233 @@
+#include "catalog.h"
+#include "workload_log.h"
+
+#include <fstream>
+#include <filesystem>
+#include <numeric>
+#include <sys/stat.h>
+
+namespace SDC{
+
+Catalog& Catalog::instance(){
+    static Catalog catalog;
+    return catalog;
+}
+
+TableSchema::TableSchema(const json& metadata_columns){
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    for(const auto& metadata_column: metadata_columns){
+        Column column{metadata_column["name"], column_dataType(metadata_column["dataType"]), int(_columns.size())};
+        _ordinals[column.name] = column.ordinal;
+        fields.push_back(arrow::field(column.name, dataType_to_arrow(column.type)));
+        _columns.push_back(column);
+    }
+    _arrow_schema = arrow::schema(fields);
+}
+
+const TableSchema::Column* TableSchema::find(const std::string& name) const {
+    auto it = _ordinals.find(name);
+    return it!=_ordinals.end() ? &_columns[it->second] : nullptr;
+}
+
+IndexMetadata::IndexMetadata(const json& metadata_index)
+:type(metadata_index["type"]), file_path(metadata_index["filePath"]), has_columns(metadata_index.contains("columns")){
+    if(has_columns){
+        for(const auto& column: metadata_index["columns"]){
+            columns.push_back(column["name"]);
+        }
+    }
+}
+
+TableMetadata::TableMetadata(json metadata)
+:metadata(std::move(metadata)), num_rows(this->metadata["num_rows"]), schema(this->metadata["columns"]){
+    for(const auto& metadata_index: this->metadata["indexes"]){
+        indexes.push_back(IndexMetadata(metadata_index));
+    }
+}
+
+std::shared_ptr<const TableMetadata> Catalog::table(const std::string& table_name, const std::string& data_directory){
+    FileLock metadata_lock(WorkloadLog::metadata_lock_path(), true);
+    std::lock_guard<std::mutex> file_lock(WorkloadLog::file_mutex());
+    std::lock_guard<std::mutex> lock(_mutex);
+    return refresh(table_name, data_directory).table;
+}
+
+json Catalog::workload(const std::string& table_name, const std::string& data_directory){
+    FileLock metadata_lock(WorkloadLog::metadata_lock_path(), true);
+    std::lock_guard<std::mutex> file_lock(WorkloadLog::file_mutex());
+    std::lock_guard<std::mutex> lock(_mutex);
+    return refresh(table_name, data_directory).workload.queries();
+}
+
+WorkloadSnapshot Catalog::snapshot(const std::string& table_name, const std::string& data_directory, const std::string& query_id, const std::vector<std::string>& filter_keys){
+    FileLock metadata_lock(WorkloadLog::metadata_lock_path(), true);
+    std::lock_guard<std::mutex> file_lock(WorkloadLog::file_mutex());
+    std::lock_guard<std::mutex> lock(_mutex);
+    const TableEntry& entry = refresh(table_name, data_directory);
+    WorkloadSnapshot snapshot;
+    snapshot.table = entry.table;
+    const json* query = entry.workload.query(query_id);
+    if(query!=nullptr){
+        snapshot.query = *query;
+    }
+    for(const auto& filter_key: filter_keys){
+        int64_t true_count;
+        int64_t false_count;
+        if(entry.workload.filter_statistics(filter_key, true_count, false_count)){
+            snapshot.filter_statistics[filter_key] = {true_count, false_count};
+        }
+    }
+    return snapshot;
+}
+
+Catalog::TableEntry& Catalog::refresh(const std::string& table_name, const std::string& data_directory){
+    WorkloadLog log(table_name, data_directory);
+    TableEntry& entry = _tables[table_name];
+    FileVersion metadata_version = file_version("../data/metadata.json");
+    FileVersion compacting_version = file_version(log.compacting_path());
+    FileVersion log_version = file_version(log.log_path());
+    bool log_truncated = entry.log_offset>0 && (!log_version.exists || log_version.inode!=entry.log_inode || log_version.size<int64_t(entry.log_offset));
+    if(!(entry.metadata_version==metadata_version) || !(entry.compacting_version==compacting_version) || log_truncated){
+        entry.metadata_version = metadata_version;
+        entry.compacting_version = compacting_version;
+        entry.log_offset = 0;
+        entry.table = nullptr;
+        entry.workload = Workload();
+        std::ifstream f("../data/metadata.json");
+        json metadata_json = json::parse(f);
+        for(auto& table: metadata_json["tables"]){
+            if(table["name"]==table_name){
+                entry.workload = Workload(table["workload"]);
+                table.erase("workload");
+                entry.table = std::make_shared<TableMetadata>(std::move(table));
+                WorkloadLog::read_records(log.compacting_path(), entry.workload);
+                break;
+            }
+        }
+    }
+
+    // records appended since the last call
+    if(entry.table!=nullptr && log_version.exists){
+        entry.log_inode = log_version.inode;
+        entry.log_offset = WorkloadLog::read_records(log.log_path(), entry.workload, entry.log_offset);
+    }
+    return entry;
+}
+
+std::shared_ptr<const PreparedIndex> Catalog::index(const IndexMetadata& metadata_index){
+    const std::string& file_path = metadata_index.file_path;
+    FileVersion version = file_version(file_path);
+    FileVersion binary_version = file_version(BinaryIndex::binary_path(file_path));
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _indexes.find(file_path);
+        if(it!=_indexes.end() && it->second.version==version && it->second.binary_version==binary_version){
+            return it->second.index;
+        }
+    }
+
+    // parsed outside of the lock, a concurrent parse of the same file only wastes work
+    bool use_binary = binary_version.exists && binary_version.modified>=version.modified;
+    std::shared_ptr<const PreparedIndex> index = parse_index(file_path, use_binary);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _indexes[file_path] = IndexEntry{version, binary_version, index};
+    return index;
+}
+
+void Catalog::invalidate(){
+    std::lock_guard<std::mutex> lock(_mutex);
+    _tables.clear();
+    _indexes.clear();
+}
+
+Catalog::FileVersion Catalog::file_version(const std::string& path){
+    FileVersion version;
+    struct stat file_stat;
+    if(stat(path.c_str(), &file_stat)==0){
+        version.exists = true;
+        version.inode = file_stat.st_ino;
+        version.size = file_stat.st_size;
+        version.modified = int64_t(file_stat.st_mtim.tv_sec)*1000000000 + file_stat.st_mtim.tv_nsec;
+    }
+    return version;
+}
+
+// reads an index file and parses the ranges of its data blocks, the binary index is only mapped
+std::shared_ptr<const PreparedIndex> Catalog::parse_index(const std::string& file_path, bool use_binary){
+    auto result = std::make_shared<PreparedIndex>();
+    result->file_path = file_path;
+    if(use_binary){
+        result->_binary = BinaryIndex::open(BinaryIndex::binary_path(file_path));
+    }
+    if(result->_binary!=nullptr){
+        result->table = result->_binary->table();
+        return result;
+    }
+
+    std::ifstream f(file_path);
+    result->_index = json::parse(f);
+    result->table = result->_index["table"];
+    for(const auto& block: result->_index["dataBlocks"]){
+        result->_first_range.push_back(result->_ranges.size());
+        if(block.contains("ranges")){
+            for(const auto& range: block["ranges"]){
+                result->_ranges.push_back(BlockRange(range));
+            }
+        }
+        const std::string& block_path = block["filePath"].get_ref<const std::string&>();
+        result->_block_rows.push_back(block.value("numRows", int64_t(-1)));
+        result->_block_bytes.push_back(std::filesystem::exists(block_path) ? std::filesystem::file_size(block_path) : 0);
+    }
+    result->_first_range.push_back(result->_ranges.size());
+    return result;
+}
+
+BlockSelection BlockSelection::all_blocks(std::shared_ptr<const PreparedIndex> index){
+    BlockSelection selection{index, std::vector<size_t>(index->num_blocks()), std::vector<bool>(index->num_blocks(), true)};
+    std::iota(selection.blocks.begin(), selection.blocks.end(), 0);
+    return selection;
+}
+
+size_t PreparedIndex::num_blocks() const {
+    return _binary!=nullptr ? _binary->num_blocks() : _block_rows.size();
+}
+
+std::string_view PreparedIndex::block_path(size_t b) const {
+    if(_binary!=nullptr){
+        return _binary->file_path(b);
+    }
+    return _index["dataBlocks"][b]["filePath"].get_ref<const std::string&>();
+}
+
+int64_t PreparedIndex::block_rows(size_t b) const {
+    return _binary!=nullptr ? _binary->num_rows(b) : _block_rows[b];
+}
+
+// a binary index stores -1 for blocks which were missing when it was written
+int64_t PreparedIndex::block_bytes(size_t b) const {
+    if(_binary==nullptr){
+        return _block_bytes[b];
+    }
+    int64_t num_bytes = _binary->num_bytes(b);
+    if(num_bytes<0){
+        std::filesystem::path block_path(_binary->file_path(b));
+        num_bytes = std::filesystem::exists(block_path) ? std::filesystem::file_size(block_path) : 0;
+    }
+    return num_bytes;
+}
+
+BlockRanges PreparedIndex::block_ranges(size_t b) const {
+    if(_binary!=nullptr){
+        return _binary->ranges(b);
+    }
+    return BlockRanges(_ranges.data()+_first_range[b], _first_range[b+1]-_first_range[b]);
+}
+
+json PreparedIndex::ranges_json(size_t b) const {
+    if(_binary!=nullptr){
+        return _binary->ranges_json(b);
+    }
+    return _index["dataBlocks"][b].value("ranges", json::array());
+}
+
+}
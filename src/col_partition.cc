@@ -24,13 +24,16 @@ ColPartition::ColPartition(std::string partition_column, std::vector<Filter>& fi
     std::sort(column_filters.begin(), column_filters.end());
     // make cuts at each filter cut, save bool mask for each leaf node
     std::string previous_cut = "";
+    const Filter* previous_filter = nullptr;
     bool previous_max_inclusive = false;
     std::shared_ptr<arrow::Array> remaining_tuples = nullptr;
     for(auto const& filter: column_filters){
         bool max_inclusive = false;
         std::shared_ptr<arrow::Array> partition_tuples;
 
-        if((filter.operator_ == "<" || filter.operator_ == "<=") && filter.constant_or_column!=previous_cut){
+        // filters are sorted by their typed constant, equal constants cut only once
+        bool is_new_cut = previous_filter==nullptr || filter.value!=previous_filter->value;
+        if((filter.operator_ == "<" || filter.operator_ == "<=") && is_new_cut){
             if(filter.operator_ == "<="){
                 max_inclusive = true;
             }
@@ -56,7 +59,7 @@ ColPartition::ColPartition(std::string partition_column, std::vector<Filter>& fi
                 partition_tuples = st.ValueOrDie().make_array();
             }
         }
-        else if((filter.operator_ == ">" || filter.operator_ == ">=") && filter.constant_or_column!=previous_cut){
+        else if((filter.operator_ == ">" || filter.operator_ == ">=") && is_new_cut){
             if(filter.operator_ == ">"){
                 max_inclusive = true;
             }
@@ -84,7 +87,7 @@ ColPartition::ColPartition(std::string partition_column, std::vector<Filter>& fi
                 auto inverted_previous_tuples = st.ValueOrDie().make_array();
                 st = arrow::compute::CallFunction("invert", {filter.boolean_mask});
                 auto inverted_filter = st.ValueOrDie().make_array();
-                st = arrow::compute::CallFunction("and", {inverted_previous_tuples, filter.boolean_mask});
+                st = arrow::compute::CallFunction("and", {inverted_previous_tuples, inverted_filter});
                 partition_tuples = st.ValueOrDie().make_array();
             }
         }
@@ -93,6 +96,7 @@ ColPartition::ColPartition(std::string partition_column, std::vector<Filter>& fi
         }
         auto part = Partition(partition_column, previous_cut, !max_inclusive, filter.constant_or_column, max_inclusive, filter.type);
         previous_cut = filter.constant_or_column;
+        previous_filter = &filter;
         previous_max_inclusive = max_inclusive;
 
         auto st = arrow::compute::CallFunction("array_filter", {partition_tuples, partition_tuples});
@@ -0,0 +1,558 @@
+#include "expression.h"
+#include "binary_index.h"
+
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <cassert>
+
+namespace SDC{
+
+std::string arrow_compute_operator(const std::string& filter_operator){
+    if(filter_operator=="=="){
+        return "equal";
+    }
+    else if(filter_operator=="<"){
+        return "less";
+    }
+    else if(filter_operator==">"){
+        return "greater";
+    }
+    else if(filter_operator=="<="){
+        return "less_equal";
+    }
+    else if(filter_operator==">="){
+        return "greater_equal";
+    }
+    else if(filter_operator=="!="){
+        return "not_equal";
+    }
+    return "";
+}
+
+Expression Expression::compare(std::string column, std::string operator_, std::string constant, bool is_col){
+    Expression expression;
+    expression.type = expressionType::comparison;
+    expression.column = column;
+    expression.operator_ = operator_;
+    expression.constants = {constant};
+    expression.is_col = is_col;
+    return expression;
+}
+
+Expression Expression::compare(Term lhs, std::string operator_, Term rhs){
+    Expression expression;
+    expression.type = expressionType::derived;
+    expression.operator_ = operator_;
+    expression.terms = {lhs, rhs};
+    return expression;
+}
+
+Expression Expression::is_in(std::string column, std::vector<std::string> values){
+    Expression expression;
+    expression.type = expressionType::in;
+    expression.column = column;
+    expression.constants = values;
+    return expression;
+}
+
+Expression Expression::between(std::string column, std::string lower, std::string upper){
+    Expression expression;
+    expression.type = expressionType::between;
+    expression.column = column;
+    expression.constants = {lower, upper};
+    return expression;
+}
+
+Expression Expression::all_of(std::vector<Expression> children){
+    Expression expression;
+    expression.type = expressionType::and_;
+    expression.children = children;
+    return expression;
+}
+
+Expression Expression::any_of(std::vector<Expression> children){
+    Expression expression;
+    expression.type = expressionType::or_;
+    expression.children = children;
+    return expression;
+}
+
+Expression Expression::negate(Expression child){
+    Expression expression;
+    expression.type = expressionType::not_;
+    expression.children = {child};
+    return expression;
+}
+
+std::string Expression::to_string() const {
+    switch(type){
+        case expressionType::comparison:{
+            return column + operator_ + constants[0];
+        }
+        case expressionType::in:{
+            std::string result = column + " IN (";
+            for(size_t k=0; k<constants.size(); k++){
+                result += (k>0 ? "," : "") + constants[k];
+            }
+            return result + ")";
+        }
+        case expressionType::between:{
+            return column + " BETWEEN " + constants[0] + " AND " + constants[1];
+        }
+        case expressionType::not_:{
+            return "NOT " + children[0].to_string();
+        }
+        case expressionType::derived:{
+            return terms[0].to_string() + operator_ + terms[1].to_string();
+        }
+        default:{
+            std::string result = "(";
+            for(size_t k=0; k<children.size(); k++){
+                result += (k>0 ? (type==expressionType::and_ ? " AND " : " OR ") : "") + children[k].to_string();
+            }
+            return result + ")";
+        }
+    }
+}
+
+json Expression::to_json() const {
+    const char* type_names[] = {"comparison", "and", "or", "not", "in", "between", "derived"};
+    json result;
+    result["type"] = type_names[type];
+    if(type==expressionType::comparison || type==expressionType::in || type==expressionType::between){
+        result["column"] = column;
+        result["constants"] = constants;
+    }
+    if(type==expressionType::comparison){
+        result["operator"] = operator_;
+        result["isCol"] = is_col;
+    }
+    if(type==expressionType::derived){
+        result["lhs"] = terms[0].to_string();
+        result["operator"] = operator_;
+        result["rhs"] = terms[1].to_string();
+    }
+    for(const auto& child: children){
+        result["children"].push_back(child.to_json());
+    }
+    return result;
+}
+
+void Expression::columns(std::vector<std::string>& result) const {
+    if(!column.empty()){
+        result.push_back(column);
+    }
+    if(is_col){
+        result.push_back(constants[0]);
+    }
+    for(const auto& term: terms){
+        term.columns(result);
+    }
+    for(const auto& child: children){
+        child.columns(result);
+    }
+}
+
+int Expression::num_leaves() const {
+    if(type==expressionType::derived){
+        return 1 + terms[0].num_operations() + terms[1].num_operations();
+    }
+    if(children.empty()){
+        return type==expressionType::in ? int(constants.size()) : 1;
+    }
+    int result = 0;
+    for(const auto& child: children){
+        result += child.num_leaves();
+    }
+    return result;
+}
+
+void Expression::parse_constants(const std::function<dataType(const std::string&)>& column_type){
+    for(auto& child: children){
+        child.parse_constants(column_type);
+    }
+    if(column.empty() || is_col){
+        return;
+    }
+    this->column_type = column_type(column);
+    values.clear();
+    _scalars.clear();
+    for(const auto& constant: constants){
+        values.push_back(parse_value(this->column_type, constant));
+        _scalars.push_back(value_to_scalar(this->column_type, values.back()));
+    }
+    if(type==expressionType::in){
+        // dictionary columns are looked up on their decoded values, constants out of a narrow integer type never match
+        std::shared_ptr<arrow::DataType> value_type = dataType_to_arrow(this->column_type);
+        std::unique_ptr<arrow::ArrayBuilder> builder;
+        arrow::Status st = arrow::MakeBuilder(arrow::default_memory_pool(), value_type, &builder);
+        assert(st.ok());
+        for(const auto& scalar: _scalars){
+            if(scalar->type->Equals(value_type)){
+                st = builder->AppendScalar(*scalar);
+                assert(st.ok());
+            }
+        }
+        st = builder->Finish(&_value_set);
+        assert(st.ok());
+    }
+}
+
+arrow::Result<arrow::Datum> Expression::column_chunk(const std::shared_ptr<arrow::Table>& table, const std::string& name, int i, const std::shared_ptr<arrow::Array>& selection) const {
+    arrow::Datum chunk = table->GetColumnByName(name)->chunk(i);
+    if(selection!=nullptr){
+        return arrow::compute::Take(chunk, selection);
+    }
+    return chunk;
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> Expression::evaluate(const std::shared_ptr<arrow::Table>& table, int i, const std::shared_ptr<arrow::Array>& selection) const {
+    arrow::Datum result;
+    switch(type){
+        case expressionType::comparison:{
+            ARROW_ASSIGN_OR_RAISE(arrow::Datum values, column_chunk(table, column, i, selection));
+            std::string function = arrow_compute_operator(operator_);
+            if(is_col){
+                ARROW_ASSIGN_OR_RAISE(arrow::Datum operand, column_chunk(table, constants[0], i, selection));
+                ARROW_ASSIGN_OR_RAISE(values, decode_dictionary(values));
+                ARROW_ASSIGN_OR_RAISE(operand, decode_dictionary(operand));
+                ARROW_ASSIGN_OR_RAISE(result, arrow::compute::CallFunction(function, {values, operand}));
+            }
+            else{
+                ARROW_ASSIGN_OR_RAISE(result, evaluate_encoded(values, [&](const arrow::Datum& v){
+                    return arrow::compute::CallFunction(function, {v, _scalars[0]});
+                }));
+            }
+            break;
+        }
+        case expressionType::in:{
+            ARROW_ASSIGN_OR_RAISE(arrow::Datum values, column_chunk(table, column, i, selection));
+            ARROW_ASSIGN_OR_RAISE(result, evaluate_encoded(values, [&](const arrow::Datum& v){
+                return arrow::compute::IsIn(v, arrow::compute::SetLookupOptions(_value_set));
+            }));
+            break;
+        }
+        case expressionType::between:{
+            ARROW_ASSIGN_OR_RAISE(arrow::Datum values, column_chunk(table, column, i, selection));
+            ARROW_ASSIGN_OR_RAISE(result, evaluate_encoded(values, [&](const arrow::Datum& v) -> arrow::Result<arrow::Datum> {
+                ARROW_ASSIGN_OR_RAISE(arrow::Datum lower, arrow::compute::CallFunction("greater_equal", {v, _scalars[0]}));
+                ARROW_ASSIGN_OR_RAISE(arrow::Datum upper, arrow::compute::CallFunction("less_equal", {v, _scalars[1]}));
+                return arrow::compute::CallFunction("and", {lower, upper});
+            }));
+            break;
+        }
+        case expressionType::derived:{
+            ARROW_ASSIGN_OR_RAISE(arrow::Datum lhs, terms[0].evaluate(table, i, selection));
+            ARROW_ASSIGN_OR_RAISE(arrow::Datum rhs, terms[1].evaluate(table, i, selection));
+            ARROW_ASSIGN_OR_RAISE(result, arrow::compute::CallFunction(arrow_compute_operator(operator_), {lhs, rhs}));
+            // comparison of two constants
+            if(result.is_scalar()){
+                int64_t length = selection!=nullptr ? selection->length() : table->column(0)->chunk(i)->length();
+                ARROW_ASSIGN_OR_RAISE(auto mask, arrow::MakeArrayFromScalar(*result.scalar(), length));
+                return mask;
+            }
+            break;
+        }
+        case expressionType::not_:{
+            ARROW_ASSIGN_OR_RAISE(auto child, children[0].evaluate(table, i, selection));
+            ARROW_ASSIGN_OR_RAISE(result, arrow::compute::CallFunction("invert", {child}));
+            break;
+        }
+        default:{
+            std::string function = type==expressionType::and_ ? "and" : "or";
+            for(const auto& child: children){
+                ARROW_ASSIGN_OR_RAISE(auto child_mask, child.evaluate(table, i, selection));
+                if(result.is_value()){
+                    ARROW_ASSIGN_OR_RAISE(result, arrow::compute::CallFunction(function, {result, child_mask}));
+                }
+                else{
+                    result = child_mask;
+                }
+            }
+        }
+    }
+    return std::move(result).make_array();
+}
+
+BlockRange::BlockRange(const json& range)
+:column(range["column"].get_ref<const std::string&>()), type(string_to_dataType(range["colDataType"])), min_inclusive(range["minInclusive"]), max_inclusive(range["maxInclusive"]){
+    has_min = range["min"]!="";
+    has_max = range["max"]!="";
+    if(has_min){
+        min = parse_value(type, range["min"]);
+    }
+    if(has_max){
+        max = parse_value(type, range["max"]);
+    }
+    make_inclusive();
+}
+
+BlockRange::BlockRange(std::string_view column, dataType type, bool has_min, Value min, bool min_inclusive, bool has_max, Value max, bool max_inclusive)
+:column(column), type(type), has_min(has_min), has_max(has_max), min(min), max(max), min_inclusive(min_inclusive), max_inclusive(max_inclusive){
+    make_inclusive();
+}
+
+void BlockRange::make_inclusive(){
+    if(has_min && is_integer_type(type) && !min_inclusive){
+        min = std::get<int64_t>(min)+1;
+        min_inclusive = true;
+    }
+    if(has_max && is_integer_type(type) && !max_inclusive){
+        max = std::get<int64_t>(max)-1;
+        max_inclusive = true;
+    }
+}
+
+// bounds of another type than the constant, e.g. of an index written before the column was retyped, cannot prune
+rangeMatch BlockRange::compare(const std::string& operator_, const Value& constant) const {
+    if((has_min && min.index()!=constant.index()) || (has_max && max.index()!=constant.index())){
+        return rangeMatch::maybe;
+    }
+    // some value >= constant / > constant, all values >= constant / > constant, a missing bound is unbounded
+    bool some_greater_equal = !has_max || max>constant || (max==constant && max_inclusive);
+    bool some_greater = !has_max || max>constant;
+    bool all_greater_equal = has_min && min>=constant;
+    bool all_greater = has_min && (min>constant || (min==constant && !min_inclusive));
+    // mirrored for the lower side
+    bool some_less_equal = !has_min || min<constant || (min==constant && min_inclusive);
+    bool some_less = !has_min || min<constant;
+    bool all_less_equal = has_max && max<=constant;
+    bool all_less = has_max && (max<constant || (max==constant && !max_inclusive));
+
+    if(operator_==">"){
+        return !some_greater ? rangeMatch::never : (all_greater ? rangeMatch::always : rangeMatch::maybe);
+    }
+    else if(operator_==">="){
+        return !some_greater_equal ? rangeMatch::never : (all_greater_equal ? rangeMatch::always : rangeMatch::maybe);
+    }
+    else if(operator_=="<"){
+        return !some_less ? rangeMatch::never : (all_less ? rangeMatch::always : rangeMatch::maybe);
+    }
+    else if(operator_=="<="){
+        return !some_less_equal ? rangeMatch::never : (all_less_equal ? rangeMatch::always : rangeMatch::maybe);
+    }
+    bool equal_never = !some_greater_equal || !some_less_equal;
+    bool equal_always = all_greater_equal && all_less_equal;
+    if(operator_=="=="){
+        return equal_never ? rangeMatch::never : (equal_always ? rangeMatch::always : rangeMatch::maybe);
+    }
+    else if(operator_=="!="){
+        return equal_always ? rangeMatch::never : (equal_never ? rangeMatch::always : rangeMatch::maybe);
+    }
+    return rangeMatch::maybe;
+}
+
+std::string_view BlockRanges::column(size_t r) const {
+    return _binary!=nullptr ? _binary->range_column(_first_range+r) : _ranges[r].column;
+}
+
+BlockRange BlockRanges::operator[](size_t r) const {
+    return _binary!=nullptr ? _binary->range(_first_range+r) : _ranges[r];
+}
+
+rangeMatch Expression::evaluate_ranges(const BlockRanges& ranges) const {
+    switch(type){
+        case expressionType::comparison:
+        case expressionType::in:
+        case expressionType::between:{
+            if(is_col){
+                return rangeMatch::maybe;
+            }
+            // a block can be bounded by several ranges on the same column, its values lie in all of them
+            rangeMatch result = rangeMatch::maybe;
+            for(size_t r=0; r<ranges.size(); r++){
+                if(ranges.column(r)!=column){
+                    continue;
+                }
+                BlockRange range = ranges[r];
+                rangeMatch match;
+                if(type==expressionType::comparison){
+                    match = range.compare(operator_, values[0]);
+                }
+                else if(type==expressionType::between){
+                    rangeMatch lower = range.compare(">=", values[0]);
+                    rangeMatch upper = range.compare("<=", values[1]);
+                    match = (lower==rangeMatch::never || upper==rangeMatch::never) ? rangeMatch::never
+                        : (lower==rangeMatch::always && upper==rangeMatch::always ? rangeMatch::always : rangeMatch::maybe);
+                }
+                else{
+                    match = rangeMatch::never;
+                    for(const auto& value: values){
+                        match = std::max(match, range.compare("==", value));
+                    }
+                }
+                if(match==rangeMatch::never){
+                    return rangeMatch::never;
+                }
+                if(match==rangeMatch::always){
+                    result = rangeMatch::always;
+                }
+            }
+            return result;
+        }
+        case expressionType::derived:{
+            Bounds lhs = terms[0].bounds(ranges);
+            Bounds rhs = terms[1].bounds(ranges);
+            bool never = false;
+            bool always = false;
+            if(operator_==">"){
+                never = lhs.max<=rhs.min;
+                always = lhs.min>rhs.max;
+            }
+            else if(operator_==">="){
+                never = lhs.max<rhs.min;
+                always = lhs.min>=rhs.max;
+            }
+            else if(operator_=="<"){
+                never = lhs.min>=rhs.max;
+                always = lhs.max<rhs.min;
+            }
+            else if(operator_=="<="){
+                never = lhs.min>rhs.max;
+                always = lhs.max<=rhs.min;
+            }
+            else if(operator_=="=="){
+                never = lhs.max<rhs.min || lhs.min>rhs.max;
+                always = lhs.min==lhs.max && rhs.min==rhs.max && lhs.min==rhs.min;
+            }
+            else if(operator_=="!="){
+                never = lhs.min==lhs.max && rhs.min==rhs.max && lhs.min==rhs.min;
+                always = lhs.max<rhs.min || lhs.min>rhs.max;
+            }
+            return never ? rangeMatch::never : (always ? rangeMatch::always : rangeMatch::maybe);
+        }
+        case expressionType::not_:{
+            rangeMatch match = children[0].evaluate_ranges(ranges);
+            return match==rangeMatch::never ? rangeMatch::always : (match==rangeMatch::always ? rangeMatch::never : rangeMatch::maybe);
+        }
+        case expressionType::and_:{
+            rangeMatch result = rangeMatch::always;
+            for(const auto& child: children){
+                result = std::min(result, child.evaluate_ranges(ranges));
+            }
+            return result;
+        }
+        case expressionType::or_:{
+            rangeMatch result = rangeMatch::never;
+            for(const auto& child: children){
+                result = std::max(result, child.evaluate_ranges(ranges));
+            }
+            return result;
+        }
+    }
+    return rangeMatch::maybe;
+}
+
+void Interval::set_min(const Value& value, bool inclusive){
+    if(!has_min || value>min || (value==min && !inclusive)){
+        has_min = true;
+        min = value;
+        min_inclusive = inclusive;
+    }
+}
+
+void Interval::set_max(const Value& value, bool inclusive){
+    if(!has_max || value<max || (value==max && !inclusive)){
+        has_max = true;
+        max = value;
+        max_inclusive = inclusive;
+    }
+}
+
+bool Interval::intersect(const std::string& operator_, const Value& constant){
+    // exclusive integer bounds become the adjacent value, unless it is out of the int64 range
+    bool is_integer = is_integer_type(type);
+    if(operator_==">"){
+        if(is_integer && std::get<int64_t>(constant)<std::numeric_limits<int64_t>::max()){
+            set_min(std::get<int64_t>(constant)+1, true);
+        }
+        else{
+            set_min(constant, false);
+        }
+    }
+    else if(operator_==">="){
+        set_min(constant, true);
+    }
+    else if(operator_=="<"){
+        if(is_integer && std::get<int64_t>(constant)>std::numeric_limits<int64_t>::min()){
+            set_max(std::get<int64_t>(constant)-1, true);
+        }
+        else{
+            set_max(constant, false);
+        }
+    }
+    else if(operator_=="<="){
+        set_max(constant, true);
+    }
+    else if(operator_=="=="){
+        intersect(">=", constant);
+        intersect("<=", constant);
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+bool Interval::is_empty() const {
+    return has_min && has_max && (min>max || (min==max && !(min_inclusive && max_inclusive)));
+}
+
+bool Interval::is_point(const Value& value) const {
+    return has_min && has_max && min==value && max==value && min_inclusive && max_inclusive;
+}
+
+std::string Interval::to_string() const {
+    std::ostringstream result;
+    auto print = [&result](const Value& value){
+        std::visit([&result](const auto& v){ result << v; }, value);
+    };
+    result << column << " in ";
+    if(has_min){
+        result << (min_inclusive ? "[" : "(");
+        print(min);
+    }
+    else{
+        result << "(-inf";
+    }
+    result << ", ";
+    if(has_max){
+        print(max);
+        result << (max_inclusive ? "]" : ")");
+    }
+    else{
+        result << "inf)";
+    }
+    return result.str();
+}
+
+arrow::Result<std::shared_ptr<arrow::Array>> Interval::evaluate(const std::shared_ptr<arrow::Table>& table, int i, const std::shared_ptr<arrow::Array>& selection) const {
+    arrow::Datum values = table->GetColumnByName(column)->chunk(i);
+    if(selection!=nullptr){
+        ARROW_ASSIGN_OR_RAISE(values, arrow::compute::Take(values, selection));
+    }
+    // bounds are scalars of the column type, bounds outside of a narrow integer type are compared as int64
+    // a point is a single equality check, otherwise one comparison per bound
+    arrow::Datum result;
+    if(is_point(min)){
+        ARROW_ASSIGN_OR_RAISE(result, arrow::compute::CallFunction("equal", {values, value_to_scalar(type, min)}));
+        return std::move(result).make_array();
+    }
+    if(has_min){
+        ARROW_ASSIGN_OR_RAISE(result, arrow::compute::CallFunction(min_inclusive ? "greater_equal" : "greater", {values, value_to_scalar(type, min)}));
+    }
+    if(has_max){
+        ARROW_ASSIGN_OR_RAISE(arrow::Datum upper_mask, arrow::compute::CallFunction(max_inclusive ? "less_equal" : "less", {values, value_to_scalar(type, max)}));
+        if(has_min){
+            ARROW_ASSIGN_OR_RAISE(result, arrow::compute::CallFunction("and", {result, upper_mask}));
+        }
+        else{
+            result = upper_mask;
+        }
+    }
+    return std::move(result).make_array();
+}
+
+}
@@ -35,20 +35,20 @@ using json = nlohmann::json;
 int qdTree_min_block_size = 10000;
 bool verbose = false;
 bool add_latency = false;
-
-enum query_index{
-  primary,
-  column_partition,
-  qdTree
-};
+bool profile = false;
 
 void reset_sdc(){
+  // fold the workload log into metadata.json, so its boolean masks are removed as well
+  SDC::WorkloadLog("NYCtaxi", "../data/NYCtaxi").compact();
+  SDC::FileLock metadata_lock(SDC::WorkloadLog::metadata_lock_path());
   std::ifstream f("../data/metadata.json");
   json metadata_json = json::parse(f);
   for(auto& table: metadata_json["tables"]){
     for(auto& query: table["workload"]){
       for(auto& filter: query["filters"]){
-        std::filesystem::remove(std::string(filter["booleanMask"]));
+        if(filter.contains("booleanMask")){
+          std::filesystem::remove(std::string(filter["booleanMask"]));
+        }
       }
     }
     table["workload"].clear();
@@ -64,6 +64,7 @@ void reset_sdc(){
           }
           // remove index file
           std::filesystem::remove(std::string(table["indexes"][i]["filePath"]));
+          std::filesystem::remove(SDC::BinaryIndex::binary_path(table["indexes"][i]["filePath"]));
           // remove qd index
           erase_indexes.push_back(i);
       }
@@ -76,6 +77,7 @@ void reset_sdc(){
           }
           // remove index file
           std::filesystem::remove(std::string(table["indexes"][i]["filePath"]));
+          std::filesystem::remove(SDC::BinaryIndex::binary_path(table["indexes"][i]["filePath"]));
           // remove columnPartition index
           erase_indexes.push_back(i);
       }
@@ -85,47 +87,46 @@ void reset_sdc(){
     }
   }
   // write out updated metadata
-  std::ofstream o2("../data/metadata.json");
-  o2 << std::setw(2) << metadata_json << std::endl;
+  SDC::WorkloadLog::write_metadata(metadata_json);
 }
 
 void run_workload_1(int index){
   auto begin = std::chrono::high_resolution_clock::now();
 
   { // 575989
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("fare_amount", ">", "20");
     table.projection({"VendorID", "fare_amount", "tip_amount", "payment_type"});
     table.head(index,5);
   }
   { // 120482
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("tip_amount", ">", "10");
     // table.filter("tip_amount", ">=", "fare_amount", true);
     table.projection({"VendorID", "fare_amount", "tip_amount", "payment_type"});
     table.head(index,5);
   }
   { // 117956
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("fare_amount", ">", "20");
     table.filter("tip_amount", ">", "10");
     table.projection({"VendorID", "fare_amount", "tip_amount", "payment_type"});
     table.head(index,5);
   }
   { // 1379502
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("tip_amount", "<", "2");
     table.projection({"VendorID", "fare_amount", "tip_amount", "payment_type"});
     table.head(index,5);
   }
   { // 213742
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("fare_amount", "<", "5");
     table.projection({"VendorID", "fare_amount", "tip_amount", "payment_type"});
     table.head(index,5);
   }
   { // 910655
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("VendorID", "<=", "1");
     table.projection({"VendorID", "fare_amount", "tip_amount", "payment_type"});
     table.head(index,5);
@@ -140,7 +141,7 @@ void run_workload_2(int index){
   auto begin = std::chrono::high_resolution_clock::now();
 
   { // 17
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("improvement_surcharge", ">", "0");
     table.filter("tolls_amount", ">=", "10");
     table.filter("tolls_amount", "<=", "10");
@@ -149,21 +150,21 @@ void run_workload_2(int index){
     table.head(index,5);
   }
   { // 89936
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("trip_distance", ">", "10");
     table.filter("tip_amount", "<", "5");
     table.projection({"tip_amount", "total_amount"});
     table.head(index,5);
   }
   { // 1839059
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("mta_tax", ">", "0");
     table.filter("extra", ">", "0");
     table.projection({"mta_tax", "extra", "total_amount", "trip_distance"});
     table.head(index,5);
   }
   { // 2802897
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("congestion_surcharge", ">", "0");
     table.filter("congestion_surcharge", "<=", "5");
     table.projection({"PULocationID", "DOLocationID", "total_amount", "congestion_surcharge"});
@@ -179,25 +180,25 @@ void run_workload_3(int index){
   auto begin = std::chrono::high_resolution_clock::now();
 
   { // 2994311
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("total_amount", "<", "60");
     table.projection({"fare_amount", "tip_amount", "total_amount", "trip_distance"});
     table.head(index,5);
   }
   { // 2894157
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("trip_distance", "<=", "10");
     table.projection({"fare_amount", "tip_amount", "total_amount", "trip_distance"});
     table.head(index,5);
   }
   { // 401169
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("tip_amount", ">=", "5");
     table.projection({"fare_amount", "tip_amount", "total_amount", "trip_distance"});
     table.head(index,5);
   }
   { // 596484
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("fare_amount", ">=", "20");
     table.projection({"fare_amount", "tip_amount", "total_amount", "trip_distance"});
     table.head(index,5);
@@ -212,7 +213,7 @@ void run_workload_4(int index){
   auto begin = std::chrono::high_resolution_clock::now();
 
   { // 360655
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("total_amount", "<", "10");
     table.projection({"VendorID", "tpep_pickup_datetime", "tpep_dropoff_datetime", "passenger_count", "trip_distance",
       "RatecodeID", "store_and_fwd_flag", "PULocationID", "DOLocationID", "payment_type", "fare_amount", "extra", "mta_tax",
@@ -220,7 +221,7 @@ void run_workload_4(int index){
     table.head(index,5);
   }
   { // 1794426
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("total_amount", ">=", "10");
     table.filter("total_amount", "<", "20");
     table.projection({"VendorID", "tpep_pickup_datetime", "tpep_dropoff_datetime", "passenger_count", "trip_distance",
@@ -229,7 +230,7 @@ void run_workload_4(int index){
     table.head(index,5);
   }
   { // 519528
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("total_amount", ">=", "20");
     table.filter("total_amount", "<", "30");
     table.projection({"VendorID", "tpep_pickup_datetime", "tpep_dropoff_datetime", "passenger_count", "trip_distance",
@@ -238,7 +239,7 @@ void run_workload_4(int index){
     table.head(index,5);
   }
   { // 147278
-    SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+    SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
     table.filter("total_amount", ">=", "30");
     table.filter("total_amount", "<", "40");
     table.projection({"VendorID", "tpep_pickup_datetime", "tpep_dropoff_datetime", "passenger_count", "trip_distance",
@@ -253,7 +254,7 @@ void run_workload_4(int index){
 }
 
 void optimize(std::string column_partition, int min_leaf_size){
-  SDC::Dataframe table("NYCtaxi", add_latency, verbose);
+  SDC::Dataframe table("NYCtaxi", add_latency, verbose, profile);
   table.optimize(column_partition, min_leaf_size);
 }
 
@@ -262,34 +263,38 @@ void run_workload(int i){
   switch(i){
     case 1:{
       reset_sdc();
-      run_workload_1(1);
+      run_workload_1(SDC::indexType::primary);
       optimize("tip_amount", qdTree_min_block_size);
-      run_workload_1(2);
-      run_workload_1(3);
+      run_workload_1(SDC::indexType::columnPartition);
+      run_workload_1(SDC::indexType::qdTree);
+      run_workload_1(SDC::indexType::automatic);
       break;
     }
     case 2:{
       reset_sdc();
-      run_workload_2(1);
+      run_workload_2(SDC::indexType::primary);
       optimize("improvement_surcharge", qdTree_min_block_size);
-      run_workload_2(2);
-      run_workload_2(3);
+      run_workload_2(SDC::indexType::columnPartition);
+      run_workload_2(SDC::indexType::qdTree);
+      run_workload_2(SDC::indexType::automatic);
       break;
     }
     case 3:{
       reset_sdc();
-      run_workload_3(1);
+      run_workload_3(SDC::indexType::primary);
       optimize("fare_amount", qdTree_min_block_size);
-      run_workload_3(2);
-      run_workload_3(3);
+      run_workload_3(SDC::indexType::columnPartition);
+      run_workload_3(SDC::indexType::qdTree);
+      run_workload_3(SDC::indexType::automatic);
       break;
     }
     case 4:{
       reset_sdc();
-      run_workload_4(1);
+      run_workload_4(SDC::indexType::primary);
       optimize("total_amount", qdTree_min_block_size);
-      run_workload_4(2);
-      run_workload_4(3);
+      run_workload_4(SDC::indexType::columnPartition);
+      run_workload_4(SDC::indexType::qdTree);
+      run_workload_4(SDC::indexType::automatic);
       break;
     }
   }
@@ -302,8 +307,14 @@ int main(int argc, char** argv) {
   if(argc>1){
     workload = std::stoi(argv[1]);
     qdTree_min_block_size = std::stoi(argv[2]);
-    if(argc==4 && argv[3]==std::string("-v")){
-      verbose = true;
+    for(int i=3; i<argc; i++){
+      if(argv[i]==std::string("-v")){
+        verbose = true;
+      }
+      else if(argv[i]==std::string("-p")){
+        // print per-stage query profile as json, one line per query
+        profile = true;
+      }
     }
   }
   run_workload(workload);
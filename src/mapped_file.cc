@@ -0,0 +1,66 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <arrow/io/api.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace SDC{
+
+std::shared_ptr<arrow::Buffer> map_file(const std::string& path){
+    if(!std::filesystem::exists(path)){
+        return nullptr;
+    }
+    auto file = arrow::io::MemoryMappedFile::Open(path, arrow::io::FileMode::READ);
+    if(!file.ok()){
+        return nullptr;
+    }
+    auto size = (*file)->GetSize();
+    if(!size.ok()){
+        return nullptr;
+    }
+    auto buffer = (*file)->ReadAt(0, *size);
+    return buffer.ok() ? *buffer : nullptr;
+}
+
+bool write_file_atomically(const std::string& path, const std::vector<std::string_view>& parts){
+    // concurrent writers of the same path each get their own temporary file
+    std::string temporary_path = path + ".XXXXXX";
+    int fd = mkstemp(temporary_path.data());
+    if(fd<0){
+        return false;
+    }
+    bool ok = fchmod(fd, 0644)==0;
+    for(std::string_view part: parts){
+        size_t written = 0;
+        while(ok && written<part.size()){
+            ssize_t n = write(fd, part.data()+written, part.size()-written);
+            if(n<0 && errno!=EINTR){
+                ok = false;
+            }
+            written += n>0 ? n : 0;
+        }
+    }
+    ok = ok && fsync(fd)==0;
+    ok = close(fd)==0 && ok;
+    ok = ok && std::rename(temporary_path.c_str(), path.c_str())==0;
+    if(!ok){
+        unlink(temporary_path.c_str());
+        return false;
+    }
+
+    // the rename is durable once the directory entry is synced
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int directory_fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(directory_fd<0){
+        return false;
+    }
+    ok = fsync(directory_fd)==0;
+    close(directory_fd);
+    return ok;
+}
+
+}
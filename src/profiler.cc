@@ -0,0 +1,46 @@
+#include "profiler.h"
+
+namespace SDC{
+
+std::string queryStage_to_string(queryStage s){
+    switch(s){
+        case queryStage::metadata_load: return "metadataLoad";
+        case queryStage::planning: return "planning";
+        case queryStage::index_load: return "indexLoad";
+        case queryStage::pruning: return "pruning";
+        case queryStage::io: return "io";
+        case queryStage::decode: return "decode";
+        case queryStage::filter: return "filter";
+        case queryStage::projection: return "projection";
+        case queryStage::update_metadata: return "updateMetadata";
+        default: return "";
+    }
+}
+
+json QueryProfile::to_json() const {
+    json result;
+    double total_wall_time = 0;
+    double total_cpu_time = 0;
+    result["stages"] = json::array();
+    for(int i=0; i<queryStage::num_stages; i++){
+        const StageMetrics& stage = stages[i];
+        json json_stage;
+        json_stage["stage"] = queryStage_to_string(queryStage(i));
+        json_stage["wallTime"] = stage.wall_time;
+        json_stage["cpuTime"] = stage.cpu_time;
+        json_stage["bytesRead"] = stage.bytes_read;
+        json_stage["rowsIn"] = stage.rows_in;
+        json_stage["rowsOut"] = stage.rows_out;
+        json_stage["blocksScanned"] = stage.blocks_scanned;
+        json_stage["blocksSkipped"] = stage.blocks_skipped;
+        json_stage["blocksFullyMatching"] = stage.blocks_fully_matching;
+        result["stages"].push_back(json_stage);
+        total_wall_time += stage.wall_time;
+        total_cpu_time += stage.cpu_time;
+    }
+    result["totalWallTime"] = total_wall_time;
+    result["totalCpuTime"] = total_cpu_time;
+    return result;
+}
+
+}
@@ -8,9 +8,10 @@
 
 namespace SDC{
 
-QDTree::QDTree(std::vector<Filter>& filters, std::vector<std::string>& projections, json& metadata, int leaf_min_size)
-:columns(projections), filters(filters), metadata(metadata), leaf_min_size(leaf_min_size){
+QDTree::QDTree(std::vector<Filter>& filters, std::vector<std::vector<Filter>>& workload, std::vector<double>& workload_weights, std::vector<std::string>& projections, json& metadata, int leaf_min_size)
+:columns(projections), filters(filters), workload(workload), workload_weights(workload_weights), metadata(metadata), leaf_min_size(leaf_min_size){
     assert(filters.size()>0);
+    assert(workload.size()==workload_weights.size());
     for(const auto& filter: filters){
         if(std::find(columns.begin(), columns.end(), filter.column)==columns.end()){
             columns.push_back(filter.column);
@@ -25,7 +26,7 @@ QDTree::QDTree(std::vector<Filter>& filters, std::vector<std::string>& projectio
     while(!nodeQueue.empty()){
         auto base_node = std::static_pointer_cast<QDNode>(nodeQueue.front());
 
-        if(make_cut(base_node, filters, metadata["workload"])){
+        if(make_cut(base_node, filters, workload)){
             nodeQueue.push(base_node->true_child);
             nodeQueue.push(base_node->false_child);
         }
@@ -49,7 +50,7 @@ std::shared_ptr<arrow::Array> QDTree::get_filter_mask(json& query_filter){
     assert(1==2);
 }
 
-bool QDTree::make_cut(std::shared_ptr<QDNode>& node, std::vector<SDC::Filter> &filters, json& workload){
+bool QDTree::make_cut(std::shared_ptr<QDNode>& node, std::vector<SDC::Filter> &filters, std::vector<std::vector<Filter>>& workload){
     if(node->num_tuples<2*leaf_min_size){
         node->type = QDNode::nodeType::leafNode;
         return false;
@@ -57,10 +58,10 @@ bool QDTree::make_cut(std::shared_ptr<QDNode>& node, std::vector<SDC::Filter> &f
 
     // given a filter:
         // loop through all workload queries, find query filters on same columm, compute discarded tuples
-        // sum up total discarded tuples over all workload queries
+        // sum up total discarded tuples over all workload queries, weighted by the executions of the query
         // discarded tuples = #true(tuples) - #true(tuples X child_filter)
     
-    int max_tuples_discarded = 0;
+    double max_tuples_discarded = 0;
     int idx_argmax_tuples_cut = -1;
     std::shared_ptr<arrow::Array> argmax_true_filtered_node_tuples;
     std::shared_ptr<arrow::Array> argmax_false_filtered_node_tuples;
@@ -106,227 +107,237 @@ bool QDTree::make_cut(std::shared_ptr<QDNode>& node, std::vector<SDC::Filter> &f
             continue;
         }
 
-        int tuples_discarded = 0;
-        for(auto query: workload){
-            for(auto query_filter: query["filters"]){
-                if(query_filter["column"]==filters[i].column && query_filter["isCol"]==filters[i].is_col){
+        double tuples_discarded = 0;
+        for(size_t q=0; q<workload.size(); q++){
+            const auto& query = workload[q];
+            for(const auto& query_filter: query){
+                if(query_filter.column==filters[i].column && !query_filter.is_col && !filters[i].is_col){
 
                     // discarded tuples = #true(tuples) - #true(tuples X filter)
+                    int discarded = 0;
                     switch(filters[i].type){
-                        case dataType::int64:{
-                            int query_cut = std::stoi(std::string(query_filter["constantOrColumn"]));
-                            int filter_cut = std::stoi(filters[i].constant_or_column);
+                        // integers, timestamps and dates: exclusive cuts are one step from inclusive ones
+                        case dataType::int64:
+                        case dataType::int32:
+                        case dataType::int8:
+                        case dataType::timestamp:
+                        case dataType::date:{
+                            int64_t query_cut = std::get<int64_t>(query_filter.value);
+                            int64_t filter_cut = std::get<int64_t>(filters[i].value);
                             if(filters[i].operator_=="<"){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="<=" && query_cut<filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut-1){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut-1){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">=" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut<filter_cut){
+                                    discarded = count_tuples_false;
                                 }
                             }
                             else if(filters[i].operator_=="<="){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut+1){
-                                    tuples_discarded += count_tuples_false;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut+1){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="<=" && query_cut<=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">=" && query_cut>filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut>filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut<=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
                             }
                             else if(filters[i].operator_==">"){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut+1){
-                                    tuples_discarded += count_tuples_true;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut+1){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="<=" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">=" && query_cut>filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut>filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
                             }
                             else if(filters[i].operator_==">="){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="<=" && query_cut<filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut-1){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut-1){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">=" && query_cut>=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut>=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut<filter_cut){
+                                    discarded = count_tuples_true;
                                 }
                             }
                             else if(filters[i].operator_=="=="){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="<=" && query_cut<filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut-1){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut-1){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">=" && query_cut>filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="!=" && query_cut==filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="!=" && query_cut==filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut==filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut==filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut!=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut!=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
                             }
                             break;
                         }
-                        case dataType::double_:{
-                            double query_cut = std::stod(std::string(query_filter["constantOrColumn"]));
-                            double filter_cut = std::stod(filters[i].constant_or_column);
+                        // doubles and strings, compared as typed values
+                        case dataType::double_:
+                        case dataType::string:{
+                            const Value& query_cut = query_filter.value;
+                            const Value& filter_cut = filters[i].value;
                             if(filters[i].operator_=="<"){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="<=" && query_cut<filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">=" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut<filter_cut){
+                                    discarded = count_tuples_false;
                                 }
                             }
                             else if(filters[i].operator_=="<="){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="<=" && query_cut<=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">=" && query_cut>filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut>filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut<=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
                             }
                             else if(filters[i].operator_==">"){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="<=" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">=" && query_cut>filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut>filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
                             }
                             else if(filters[i].operator_==">="){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="<=" && query_cut<filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_==">=" && query_cut>=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_false;
+                                else if(query_filter.operator_=="==" && query_cut>=filter_cut){
+                                    discarded = count_tuples_false;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut<filter_cut){
+                                    discarded = count_tuples_true;
                                 }
                             }
                             else if(filters[i].operator_=="=="){
-                                if(query_filter["operator"]=="<" && query_cut<=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                if(query_filter.operator_=="<" && query_cut<=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="<=" && query_cut<filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="<=" && query_cut<filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">" && query_cut>=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">" && query_cut>=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]==">=" && query_cut>filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_==">=" && query_cut>filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="!=" && query_cut==filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="!=" && query_cut==filter_cut){
+                                    discarded = count_tuples_true;
                                 }
-                                else if(query_filter["operator"]=="==" && query_cut!=filter_cut){
-                                    tuples_discarded += count_tuples_true;
+                                else if(query_filter.operator_=="==" && query_cut!=filter_cut){
+                                    discarded = count_tuples_true;
                                 }
                             }
                             break;
                         }
                     }
+                    tuples_discarded += workload_weights[q]*discarded;
                     break;
                 }
             }
@@ -373,95 +384,56 @@ bool QDTree::make_cut(std::shared_ptr<QDNode>& node, std::vector<SDC::Filter> &f
 }
 
 std::vector<QDNodeRange> QDTree::add_range(std::vector<QDNodeRange> ranges, const Filter& filter, bool is_true_child){
-    bool found_range;
+    bool found_range = false;
     for(auto& range: ranges){
         if(range.column==filter.column){
-            switch(range.col_data_type){
-                case dataType::int64:{
-                    if(filter.operator_=="<" && !filter.is_col && (range.max=="" || std::stoi(filter.constant_or_column)<std::stoi(range.max))){
-                        if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = false;
-                        }
-                        else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = true;
-                        }
-                    }
-                    else if(filter.operator_=="=<" && !filter.is_col && (range.max=="" || std::stoi(filter.constant_or_column)<std::stoi(range.max))){
-                         if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = true;
-                         }
-                         else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = false;
-                         }
-                    }
-                    else if(filter.operator_==">" && !filter.is_col && (range.min=="" || std::stoi(filter.constant_or_column)>std::stoi(range.min))){
-                        if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = false;
-                        }
-                        else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = true;
-                        }
-                    }
-                    else if(filter.operator_==">=" && !filter.is_col && (range.min=="" || std::stoi(filter.constant_or_column)>std::stoi(range.min))){
-                        if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = true;
-                        }
-                        else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = false;
-                        }
-                    }
-                    break;
+            // bounds are compared as typed values
+            if(filter.operator_=="<" && !filter.is_col && (range.max=="" || filter.value<range.max_value)){
+                if(is_true_child){
+                    range.max = filter.constant_or_column;
+                    range.max_value = filter.value;
+                    range.max_inclusive = false;
                 }
-                case dataType::double_:{
-                    if(filter.operator_=="<" && !filter.is_col && (range.max=="" || std::stod(filter.constant_or_column)<std::stod(range.max))){
-                        if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = false;
-                        }
-                        else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = true;
-                        }
-                    }
-                    else if(filter.operator_=="=<" && !filter.is_col && (range.max=="" || std::stod(filter.constant_or_column)<std::stod(range.max))){
-                        if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = true;
-                        }
-                        else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = false;
-                        }
-                    }
-                    else if(filter.operator_==">" && !filter.is_col && (range.min=="" || std::stod(filter.constant_or_column)>std::stod(range.min))){
-                        if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = false;
-                        }
-                        else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = true;
-                        }
-                    }
-                    else if(filter.operator_==">=" && !filter.is_col && (range.min=="" || std::stod(filter.constant_or_column)>std::stod(range.min))){
-                        if(is_true_child){
-                            range.max = filter.constant_or_column;
-                            range.max_inclusive = true;
-                        }
-                        else{
-                            range.min = filter.constant_or_column;
-                            range.min_inclusive = false;
-                        }
-                    }
-                    break;
+                else{
+                    range.min = filter.constant_or_column;
+                    range.min_value = filter.value;
+                    range.min_inclusive = true;
+                }
+            }
+            else if(filter.operator_=="<=" && !filter.is_col && (range.max=="" || filter.value<range.max_value)){
+                 if(is_true_child){
+                    range.max = filter.constant_or_column;
+                    range.max_value = filter.value;
+                    range.max_inclusive = true;
+                 }
+                 else{
+                    range.min = filter.constant_or_column;
+                    range.min_value = filter.value;
+                    range.min_inclusive = false;
+                 }
+            }
+            else if(filter.operator_==">" && !filter.is_col && (range.min=="" || filter.value>range.min_value)){
+                if(is_true_child){
+                    range.min = filter.constant_or_column;
+                    range.min_value = filter.value;
+                    range.min_inclusive = false;
+                }
+                else{
+                    range.max = filter.constant_or_column;
+                    range.max_value = filter.value;
+                    range.max_inclusive = true;
+                }
+            }
+            else if(filter.operator_==">=" && !filter.is_col && (range.min=="" || filter.value>range.min_value)){
+                if(is_true_child){
+                    range.min = filter.constant_or_column;
+                    range.min_value = filter.value;
+                    range.min_inclusive = true;
+                }
+                else{
+                    range.max = filter.constant_or_column;
+                    range.max_value = filter.value;
+                    range.max_inclusive = false;
                 }
             }
             found_range = true;
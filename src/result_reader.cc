@@ -0,0 +1,84 @@
+#include "result_reader.h"
+#include "sdc.h"
+
+namespace SDC{
+
+ResultReader::ResultReader(Dataframe& dataframe, BlockSelection selection, std::shared_ptr<arrow::Schema> schema)
+:_dataframe(dataframe), _selection(std::move(selection)), _schema(schema){
+    _true_counts.resize(_dataframe._filters.size(), 0);
+    _false_counts.resize(_dataframe._filters.size(), 0);
+    _boolean_masks.resize(_dataframe._filters.size());
+    if(_schema==nullptr){
+        // the schema of the result depends on the projections and the column types of the blocks
+        _table = next_table();
+        _schema = _table!=nullptr ? _table->schema() : _dataframe.empty_result()->schema();
+        if(_table!=nullptr){
+            _batches = std::make_unique<arrow::TableBatchReader>(*_table);
+        }
+    }
+}
+
+std::shared_ptr<arrow::Schema> ResultReader::schema() const {
+    return _schema;
+}
+
+arrow::Status ResultReader::ReadNext(std::shared_ptr<arrow::RecordBatch>* batch){
+    while(true){
+        if(_batches!=nullptr){
+            ARROW_RETURN_NOT_OK(_batches->ReadNext(batch));
+            if(*batch!=nullptr){
+                return arrow::Status::OK();
+            }
+            _batches.reset();
+        }
+        _table = next_table();
+        if(_table==nullptr){
+            finish();
+            *batch = nullptr;
+            return arrow::Status::OK();
+        }
+        _batches = std::make_unique<arrow::TableBatchReader>(*_table);
+    }
+}
+
+std::shared_ptr<arrow::Table> ResultReader::next_table(){
+    if(_next_block>=_selection.blocks.size()){
+        return nullptr;
+    }
+    _dataframe._fully_matching_chunks.clear();
+    std::shared_ptr<arrow::Table> table = _dataframe.load_block(_selection, _next_block);
+    _next_block++;
+    std::shared_ptr<arrow::Table> result = _dataframe.evaluate_query(table);
+    for(size_t f=0; f<_dataframe._filters.size(); f++){
+        const Filter& filter = _dataframe._filters[f];
+        _true_counts[f] += filter.true_count;
+        _false_counts[f] += filter.false_count;
+        if(_dataframe._record_masks && filter.boolean_mask!=nullptr){
+            _boolean_masks[f].push_back(filter.boolean_mask);
+        }
+    }
+    return result;
+}
+
+void ResultReader::finish(){
+    if(_finished){
+        return;
+    }
+    _finished = true;
+    // contradicting filters match no row, nothing is recorded as by head
+    if(_dataframe._is_contradiction){
+        return;
+    }
+    for(size_t f=0; f<_dataframe._filters.size(); f++){
+        Filter& filter = _dataframe._filters[f];
+        filter.true_count = _true_counts[f];
+        filter.false_count = _false_counts[f];
+        if(!_boolean_masks[f].empty()){
+            filter.boolean_mask = arrow::Concatenate(_boolean_masks[f]).ValueOrDie();
+        }
+    }
+    StageTimer timer(_dataframe._profile[queryStage::update_metadata]);
+    _dataframe.update_metadata();
+}
+
+}
@@ -1,7 +1,9 @@
 #include "sdc.h"
+#include "mapped_file.h"
 #include "nlohmann/json.hpp"
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 #include <iostream>
 #include <bitset>
 #include <filesystem>
@@ -10,30 +12,33 @@
 #include <chrono>
 #include <thread>
 #include <filesystem>
+#include <atomic>
+#include <stdexcept>
 
 namespace SDC{
 
 void Dataframe::head(int use_index, int rows){
-    // load meta data block (with indexes/tables)
-    _metadata = load_metadata();
-
-    // loads most suitable index for query
-    json index = load_index(use_index);
+    if(!plan_query(use_index)){
+        std::shared_ptr<arrow::Table> filtered_table = empty_result();
+        if(_verbose){
+            std::cout << "contradicting filters, no data loaded" << std::endl;
+            std::cout << "number of filtered_rows: " << filtered_table->num_rows() << std::endl;
+            PARQUET_THROW_NOT_OK(arrow::PrettyPrint(*filtered_table, 4, &std::cout));
+        }
+        if(_profiling){
+            std::cout << profile().dump() << std::endl;
+        }
+        return;
+    }
     
-    // load data blocks from most suitable index
-    std::shared_ptr<arrow::Table> table = load_data(index);
+    // load the data blocks selected from the most suitable index
+    std::shared_ptr<arrow::Table> table = load_data(_selection);
     
     if(_verbose){
         std::cout << "number of loaded rows: " << table->num_rows() << std::endl;
     }
 
-    // apply filters
-    std::vector<std::shared_ptr<arrow::Array>> filter_mask;
-    arrow::Status st = compute_filter_mask(table, filter_mask);
-    assert(st.ok()); 
-
-    // apply projections
-    std::shared_ptr<arrow::Table> filtered_table = apply_filters_projections(table, _projections, filter_mask);
+    std::shared_ptr<arrow::Table> filtered_table = evaluate_query(table);
 
     // apply group by
 
@@ -45,7 +50,198 @@ void Dataframe::head(int use_index, int rows){
     }
 
     // update metadata (& upload boolean mask, if primary key was used)
-    update_metadata();
+    {
+        StageTimer timer(_profile[queryStage::update_metadata]);
+        update_metadata();
+    }
+
+    if(_profiling){
+        std::cout << profile().dump() << std::endl;
+    }
+}
+
+std::shared_ptr<arrow::RecordBatchReader> Dataframe::scan(int use_index){
+    if(!plan_query(use_index)){
+        return std::make_shared<ResultReader>(*this, BlockSelection(), empty_result()->schema());
+    }
+    return std::make_shared<ResultReader>(*this, _selection, nullptr);
+}
+
+// loads the metadata, merges the filters, selects the index and prunes its blocks. False if the filters
+// contradict each other, the query then matches no row and no index is loaded.
+bool Dataframe::plan_query(int use_index){
+    _profile.reset();
+    _index_selection = json();
+
+    check_parameters_bound();
+
+    // load meta data block (with indexes/tables) and the workload entries of the query, prepared queries keep their metadata
+    {
+        StageTimer timer(_profile[queryStage::metadata_load]);
+        _workload_snapshot = load_workload_snapshot();
+        if(!_is_prepared){
+            _table_metadata = _workload_snapshot.table;
+        }
+    }
+
+    // merge comparisons on the same column, a contradiction cannot match any row
+    {
+        StageTimer timer(_profile[queryStage::planning]);
+        normalize_filters();
+    }
+    if(_is_contradiction){
+        return false;
+    }
+
+    // most suitable index for the query and its blocks to scan
+    _selection = load_index(use_index);
+    size_t num_fully_matching = std::count(_selection.fully_matching.begin(), _selection.fully_matching.end(), true);
+    _profile[queryStage::pruning].blocks_scanned = _selection.blocks.size();
+    _profile[queryStage::pruning].blocks_skipped = _selection.index->num_blocks() - _selection.blocks.size();
+    _profile[queryStage::pruning].blocks_fully_matching = num_fully_matching;
+    {
+        StageTimer timer(_profile[queryStage::planning]);
+        _record_masks = is_mask_sampled();
+    }
+    return true;
+}
+
+// filters and projections of loaded data blocks
+std::shared_ptr<arrow::Table> Dataframe::evaluate_query(std::shared_ptr<arrow::Table> table){
+    // apply filters
+    std::vector<std::shared_ptr<arrow::Array>> filter_mask;
+    {
+        StageTimer timer(_profile[queryStage::filter]);
+        table = split_morsels(table);
+        arrow::Status st = compute_filter_mask(table, filter_mask);
+        assert(st.ok()); 
+    }
+
+    // apply projections
+    std::shared_ptr<arrow::Table> filtered_table;
+    {
+        StageTimer timer(_profile[queryStage::projection]);
+        filtered_table = apply_projections(table, filter_mask);
+    }
+    _profile[queryStage::filter].rows_in += table->num_rows();
+    _profile[queryStage::filter].rows_out += filtered_table->num_rows();
+    _profile[queryStage::projection].rows_in += filtered_table->num_rows();
+    _profile[queryStage::projection].rows_out += filtered_table->num_rows();
+    return filtered_table;
+}
+
+json Dataframe::profile(){
+    json result = _profile.to_json();
+    result["table"] = _table_name;
+    result["queryID"] = get_query_id();
+    result["index"] = _index_type;
+    result["indexSelection"] = _index_selection;
+    return result;
+}
+
+// plans the query without executing it: chosen index, surviving blocks (and the range which 
+// excluded each pruned block), estimated rows and bytes. With analyze the query is executed 
+// and actual per-stage values are reported next to the estimates.
+json Dataframe::explain(int use_index, bool analyze){
+    _index_selection = json();
+    check_parameters_bound();
+    _workload_snapshot = load_workload_snapshot();
+    _table_metadata = _workload_snapshot.table;
+    normalize_filters();
+
+    json plan;
+    plan["table"] = _table_name;
+    plan["queryID"] = get_query_id();
+    plan["intervals"] = json::array();
+    for(const auto& interval: _intervals){
+        plan["intervals"].push_back(interval.to_string());
+    }
+    plan["contradiction"] = _is_contradiction;
+    if(_is_contradiction){
+        return plan;
+    }
+
+    _selection = load_index(use_index);
+    const PreparedIndex& index = *_selection.index;
+    plan["index"] = _index_type;
+    plan["indexSelection"] = _index_selection;
+    plan["blocks"] = json::array();
+
+    int64_t blocks_scanned = 0;
+    int64_t blocks_skipped = 0;
+    int64_t estimated_rows = 0;
+    int64_t estimated_bytes = 0;
+    for(size_t b=0; b<index.num_blocks(); b++){
+        json reason;
+        bool is_relevant = is_relevant_block(index, b, &reason);
+
+        int64_t num_rows = block_num_rows(index, b);
+        int64_t num_bytes = index.block_bytes(b);
+
+        json json_block;
+        json_block["filePath"] = index.block_path(b);
+        json_block["relevant"] = is_relevant;
+        json_block["fullyMatching"] = is_relevant && is_fully_matching_block(index, b);
+        json_block["numRows"] = num_rows;
+        json_block["bytes"] = num_bytes;
+        if(is_relevant){
+            blocks_scanned++;
+            estimated_rows += num_rows;
+            estimated_bytes += num_bytes;
+        }
+        else{
+            blocks_skipped++;
+            json_block["excludedBy"] = reason;
+        }
+        plan["blocks"].push_back(json_block);
+    }
+
+    // estimate filter selectivity from workload statistics, assuming independent filters
+    // (no statistics are recorded for expressions)
+    double selectivity = 1;
+    bool has_selectivity = _expressions.empty();
+    for(const auto& filter: _filters){
+        int64_t true_count;
+        int64_t false_count;
+        if(workload_filter_statistics(filter, true_count, false_count) && true_count+false_count>0){
+            selectivity *= double(true_count)/(true_count+false_count);
+        }
+        else{
+            has_selectivity = false;
+        }
+    }
+
+    json estimated;
+    estimated["blocksScanned"] = blocks_scanned;
+    estimated["blocksSkipped"] = blocks_skipped;
+    estimated["rows"] = estimated_rows;
+    estimated["bytes"] = estimated_bytes;
+    // workload statistics are relative to the whole table, not only to the surviving blocks
+    int64_t num_rows = _table_metadata->num_rows;
+    estimated["filteredRows"] = has_selectivity ? json(std::min(estimated_rows, int64_t(num_rows*selectivity))) : json();
+    plan["estimated"] = estimated;
+
+    if(analyze){
+        head(use_index, 0);
+        json actual = profile();
+        plan["actual"] = actual;
+
+        auto stage = [&actual](queryStage s) -> const json& {
+            return actual["stages"][int(s)];
+        };
+        plan["stages"] = json::array();
+        plan["stages"].push_back({{"stage", queryStage_to_string(queryStage::pruning)},
+            {"estimatedBlocksScanned", blocks_scanned}, {"actualBlocksScanned", stage(queryStage::pruning)["blocksScanned"]},
+            {"estimatedBlocksSkipped", blocks_skipped}, {"actualBlocksSkipped", stage(queryStage::pruning)["blocksSkipped"]}});
+        plan["stages"].push_back({{"stage", queryStage_to_string(queryStage::io)},
+            {"estimatedBytesRead", estimated_bytes}, {"actualBytesRead", stage(queryStage::io)["bytesRead"]}});
+        plan["stages"].push_back({{"stage", queryStage_to_string(queryStage::decode)},
+            {"estimatedRowsOut", estimated_rows}, {"actualRowsOut", stage(queryStage::decode)["rowsOut"]}});
+        plan["stages"].push_back({{"stage", queryStage_to_string(queryStage::filter)},
+            {"estimatedRowsOut", estimated["filteredRows"]}, {"actualRowsOut", stage(queryStage::filter)["rowsOut"]}});
+    }
+
+    return plan;
 }
 
 void Dataframe::add_latency(std::string path){
@@ -60,20 +256,13 @@ void Dataframe::add_latency(std::string path){
     return;
 }
 
-dataType Dataframe::get_col_dataType(std::string column){
-    dataType result;
-    for(auto& col: _metadata["columns"]){
-        if(col["name"]==column){
-            if(col["dataType"]=="int64"){
-                result = dataType::int64;
-            }
-            else if(col["dataType"]=="double"){
-                result = dataType::double_;
-            }
-            break;
-        }
+// constants are parsed as the column type, a mistyped column name is an error instead of a guessed type
+dataType Dataframe::get_col_dataType(const std::string& column){
+    const TableSchema::Column* col = _table_metadata!=nullptr ? _table_metadata->schema.find(column) : nullptr;
+    if(col==nullptr){
+        throw std::invalid_argument("unknown column " + column + " of table " + _table_name);
     }
-    return result;
+    return col->type;
 }
 
 void Dataframe::apply_group_by(const std::shared_ptr<arrow::Table>& table){
@@ -97,37 +286,42 @@ void Dataframe::group_by(std::string function_name){
 
 std::shared_ptr<arrow::Table> Dataframe::apply_filters_projections(const std::shared_ptr<arrow::Table>& table, const std::vector<std::string>& projections, std::vector<std::shared_ptr<arrow::Array>> boolean_masks){
     
-    std::vector<std::shared_ptr<arrow::Table>> table_chunks;
-    for(size_t j=0; j<boolean_masks.size(); j++){
-        std::vector<std::shared_ptr<arrow::Array>> filtered_arrays;
-        std::shared_ptr<arrow::Schema> schema = table->schema();
-        std::vector<int> schema_drop_fields;
-
-        auto columns = table->columns();
-        for(int i=0; i<columns.size(); i++){
-            if(std::find(projections.begin(),projections.end(),table->field(i)->name())!=projections.end() || projections.empty()){
-                assert(columns[i]->num_chunks()==boolean_masks.size());
-                auto a1 = columns[i];
-                auto a = columns[i]->chunk(j);
-                auto b = boolean_masks[j];
-                auto st = arrow::compute::CallFunction("array_filter", {columns[i]->chunk(j), boolean_masks[j]});
-                std::shared_ptr<arrow::Array> filtered_array = st.ValueOrDie().make_array();
-                filtered_arrays.push_back(filtered_array);
-            }
-            else{
-                schema_drop_fields.push_back(i);
-            }
+    // fields kept by projection
+    std::vector<int> projection_fields;
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    for(int i=0; i<table->num_columns(); i++){
+        if(std::find(projections.begin(),projections.end(),table->field(i)->name())!=projections.end() || projections.empty()){
+            projection_fields.push_back(i);
+            fields.push_back(table->field(i));
         }
+    }
+    std::shared_ptr<arrow::Schema> schema = arrow::schema(fields, table->schema()->metadata());
 
-        for(int i=schema_drop_fields.size()-1; i>=0; i--){
-            auto result = schema->RemoveField(schema_drop_fields[i]);
-            if(!result.ok()){
-                std::cout << result.status().ToString() << std::endl;
+    // filter chunks in parallel, each chunk writes its own slot to keep the order
+    std::vector<std::shared_ptr<arrow::Table>> table_chunks(boolean_masks.size());
+    ThreadPool::instance().parallel_for(boolean_masks.size(), [&](size_t j){
+        std::vector<std::shared_ptr<arrow::Array>> filtered_arrays;
+        for(int i: projection_fields){
+            assert(table->column(i)->num_chunks()==boolean_masks.size());
+            // no mask: all rows of the chunk qualify, pass through without copying
+            if(boolean_masks[j]==nullptr){
+                filtered_arrays.push_back(table->column(i)->chunk(j));
+                continue;
+            }
+            // selection vector: gather the selected rows, boolean mask: filter the whole chunk
+            if(boolean_masks[j]->type_id()==arrow::Type::UINT64){
+                auto st = arrow::compute::Take(table->column(i)->chunk(j), boolean_masks[j]);
+                filtered_arrays.push_back(st.ValueOrDie().make_array());
+                continue;
             }
-            schema = result.ValueOrDie();
+            auto st = arrow::compute::CallFunction("array_filter", {table->column(i)->chunk(j), boolean_masks[j]});
+            filtered_arrays.push_back(st.ValueOrDie().make_array());
         }
+        table_chunks[j] = arrow::Table::Make(schema, filtered_arrays);
+    });
 
-        table_chunks.push_back(arrow::Table::Make(schema, filtered_arrays));
+    if(table_chunks.empty()){
+        return arrow::Table::MakeEmpty(schema).ValueOrDie();
     }
 
     // merge tables
@@ -138,83 +332,357 @@ std::shared_ptr<arrow::Table> Dataframe::apply_filters_projections(const std::sh
     return result.ValueOrDie();
 }
 
+// projections and derived projections of the chunks, filtered by their masks
+std::shared_ptr<arrow::Table> Dataframe::apply_projections(const std::shared_ptr<arrow::Table>& table, const std::vector<std::shared_ptr<arrow::Array>>& boolean_masks){
+    // columns only read by derived projections are dropped again after these are computed
+    std::vector<std::string> projections = _projections;
+    if(!_projections.empty()){
+        for(const auto& derived: _derived_projections){
+            derived.second.columns(projections);
+        }
+    }
+    return apply_derived_projections(apply_filters_projections(table, projections, boolean_masks));
+}
+
+// appends the derived projections, evaluated on the filtered rows only, and drops columns which were only read by them
+std::shared_ptr<arrow::Table> Dataframe::apply_derived_projections(const std::shared_ptr<arrow::Table>& table){
+    if(_derived_projections.empty()){
+        return table;
+    }
+    std::shared_ptr<arrow::Table> result = table;
+    for(const auto& derived: _derived_projections){
+        arrow::ArrayVector chunks;
+        int num_chunks = table->num_columns()>0 ? table->column(0)->num_chunks() : 0;
+        for(int i=0; i<num_chunks; i++){
+            arrow::Datum values = derived.second.evaluate(table, i, nullptr).ValueOrDie();
+            if(values.is_scalar()){
+                values = arrow::MakeArrayFromScalar(*values.scalar(), table->column(0)->chunk(i)->length()).ValueOrDie();
+            }
+            chunks.push_back(values.make_array());
+        }
+        std::shared_ptr<arrow::DataType> type = chunks.empty() ? arrow::float64() : chunks[0]->type();
+        auto column = std::make_shared<arrow::ChunkedArray>(chunks, type);
+        result = result->AddColumn(result->num_columns(), arrow::field(derived.first, type), column).ValueOrDie();
+    }
+
+    if(_projections.empty()){
+        return result;
+    }
+    std::vector<int> kept_columns;
+    for(int i=0; i<result->num_columns(); i++){
+        if(i>=table->num_columns() || std::find(_projections.begin(), _projections.end(), result->field(i)->name())!=_projections.end()){
+            kept_columns.push_back(i);
+        }
+    }
+    return result->SelectColumns(kept_columns).ValueOrDie();
+}
+
+// splits chunks into zero-copy slices of at most _morsel_size rows, the unit of parallel work
+std::shared_ptr<arrow::Table> Dataframe::split_morsels(const std::shared_ptr<arrow::Table>& table){
+    std::vector<bool> fully_matching_morsels;
+    if(table->num_columns()>0){
+        for(int i=0; i<table->column(0)->num_chunks(); i++){
+            int64_t num_morsels = (table->column(0)->chunk(i)->length() + _morsel_size - 1) / _morsel_size;
+            fully_matching_morsels.insert(fully_matching_morsels.end(), num_morsels, _fully_matching_chunks[i]);
+        }
+    }
+    _fully_matching_chunks = fully_matching_morsels;
+
+    std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+    for(const auto& column: table->columns()){
+        arrow::ArrayVector morsels;
+        for(const auto& chunk: column->chunks()){
+            for(int64_t offset=0; offset<chunk->length(); offset+=_morsel_size){
+                morsels.push_back(chunk->Slice(offset, _morsel_size));
+            }
+        }
+        columns.push_back(std::make_shared<arrow::ChunkedArray>(morsels, column->type()));
+    }
+    return arrow::Table::Make(table->schema(), columns, table->num_rows());
+}
+
+// new queries evaluate every filter on every row, their per-filter statistics (and masks on the primary index)
+// are recorded in the workload. Repeated queries evaluate filters ordered by observed selectivity and cost,
+// and once few rows survive, later filters only on the surviving rows (selection vector of row indices).
+// The mask of a chunk is nullptr if all rows qualify, a selection vector if few rows qualify, otherwise a bitmap.
 arrow::Status Dataframe::compute_filter_mask(std::shared_ptr<arrow::Table> table, std::vector<std::shared_ptr<arrow::Array>>& masks){
 
-    std::vector<std::vector<std::shared_ptr<arrow::Array>>> chunks_filters_boolean_masks; // for each chunk, all filter masks 
-    for(size_t i=0; i<table->column(0)->num_chunks(); i++){
-        std::vector<std::shared_ptr<arrow::Array>> filters_boolean_masks;
-        for(auto& filter: _filters){
-            std::shared_ptr<arrow::Array> column_array = table->GetColumnByName(filter.column)->chunk(i); 
-            arrow::Datum boolean_mask_datum;
-            if(filter.is_col){
-                std::shared_ptr<arrow::Array> compare_column_array = table->GetColumnByName(filter.constant_or_column)->chunk(i); 
-                ARROW_ASSIGN_OR_RAISE(boolean_mask_datum,arrow::compute::CallFunction(get_arrow_compute_operator(filter.operator_), {column_array, compare_column_array}));
+    // resolve columns once, before chunks are evaluated in parallel
+    std::vector<std::shared_ptr<arrow::ChunkedArray>> filter_columns;
+    std::vector<arrow::Datum> filter_operands;
+    for(const auto& filter: _filters){
+        filter_columns.push_back(table->GetColumnByName(filter.column));
+        if(filter.is_col){
+            filter_operands.push_back(table->GetColumnByName(filter.constant_or_column));
+        }
+        else{
+            filter_operands.push_back(filter.scalar);
+        }
+    }
+
+    // predicates are the filters, the expressions and the merged intervals
+    size_t num_predicates = _filters.size() + _expressions.size() + _intervals.size();
+    size_t first_interval = _filters.size() + _expressions.size();
+
+    // evaluate predicate f on chunk i, restricted to the selected rows if there is a selection
+    auto evaluate_filter = [&](size_t f, size_t i, const std::shared_ptr<arrow::Array>& selection) -> arrow::Result<std::shared_ptr<arrow::Array>> {
+        if(f>=first_interval){
+            return _intervals[f-first_interval].evaluate(table, i, selection);
+        }
+        if(f>=_filters.size()){
+            return _expressions[f-_filters.size()].evaluate(table, i, selection);
+        }
+        arrow::Datum column = filter_columns[f]->chunk(i);
+        arrow::Datum operand = filter_operands[f];
+        if(_filters[f].is_col){
+            operand = operand.chunked_array()->chunk(i);
+        }
+        if(selection!=nullptr){
+            ARROW_ASSIGN_OR_RAISE(column, arrow::compute::Take(column, selection));
+            if(_filters[f].is_col){
+                ARROW_ASSIGN_OR_RAISE(operand, arrow::compute::Take(operand, selection));
             }
-            else{
-                std::shared_ptr<arrow::Scalar> constant;
-                switch(get_col_dataType(filter.column)){
-                    case dataType::int64:{
-                        constant = arrow::MakeScalar<int64_t>(std::stoi(filter.constant_or_column));
-                        break;
+        }
+        std::string function = get_arrow_compute_operator(_filters[f].operator_);
+        arrow::Datum boolean_mask_datum;
+        if(_filters[f].is_col){
+            ARROW_ASSIGN_OR_RAISE(column, decode_dictionary(column));
+            ARROW_ASSIGN_OR_RAISE(operand, decode_dictionary(operand));
+            ARROW_ASSIGN_OR_RAISE(boolean_mask_datum, arrow::compute::CallFunction(function, {column, operand}));
+        }
+        else{
+            // dictionary encoded columns compare the constant with each dictionary entry only
+            ARROW_ASSIGN_OR_RAISE(boolean_mask_datum, evaluate_encoded(column, [&](const arrow::Datum& values){
+                return arrow::compute::CallFunction(function, {values, operand});
+            }));
+        }
+        return std::move(boolean_mask_datum).make_array();
+    };
+
+    // an execution recording the boolean masks evaluates every filter on all rows
+    bool adaptive = is_query_in_workload() && !_record_masks;
+
+    // selectivity statistics: prior from the workload, observations are shared between chunks
+    std::vector<double> prior_evaluated(num_predicates, 0);
+    std::vector<double> prior_passed(num_predicates, 0);
+    std::vector<std::atomic<int64_t>> rows_evaluated(num_predicates);
+    std::vector<std::atomic<int64_t>> rows_passed(num_predicates);
+    for(size_t f=0; f<num_predicates; f++){
+        int64_t true_count;
+        int64_t false_count;
+        if(f<_filters.size() && workload_filter_statistics(_filters[f], true_count, false_count) && true_count+false_count>0){
+            // weigh the prior like a single morsel of observations
+            prior_evaluated[f] = std::min<double>(true_count+false_count, _morsel_size);
+            prior_passed[f] = prior_evaluated[f] * true_count / (true_count+false_count);
+        }
+        rows_evaluated[f] = 0;
+        rows_passed[f] = 0;
+    }
+    // an interval is at least as selective as the most selective of its filters
+    for(size_t f=first_interval; f<num_predicates; f++){
+        for(size_t merged: _intervals[f-first_interval].filters){
+            if(prior_evaluated[merged]>0 && (prior_evaluated[f]==0 || prior_passed[merged]/prior_evaluated[merged] < prior_passed[f]/prior_evaluated[f])){
+                prior_evaluated[f] = prior_evaluated[merged];
+                prior_passed[f] = prior_passed[merged];
+            }
+        }
+    }
+
+    // new queries evaluate every filter and expression, repeated queries replace merged filters by their interval
+    std::vector<size_t> predicates;
+    std::vector<bool> is_merged(_filters.size(), false);
+    for(const auto& interval: _intervals){
+        for(size_t merged: interval.filters){
+            is_merged[merged] = true;
+        }
+    }
+    for(size_t f=0; f<num_predicates; f++){
+        if(f<_filters.size() && adaptive && is_merged[f]){
+            continue;
+        }
+        if(f>=first_interval && !adaptive){
+            continue;
+        }
+        predicates.push_back(f);
+    }
+
+    // most rows discarded per unit of cost first, comparing two columns costs twice a constant comparison,
+    // an expression costs one comparison per leaf, an interval a single range check
+    auto filter_order = [&](){
+        std::vector<size_t> order = predicates;
+        std::vector<double> rank(num_predicates);
+        for(size_t f: predicates){
+            double selectivity = (prior_passed[f] + rows_passed[f] + 1) / (prior_evaluated[f] + rows_evaluated[f] + 2);
+            double cost = 1;
+            if(f<_filters.size()){
+                cost = _filters[f].is_col ? 2 : 1;
+            }
+            else if(f<first_interval){
+                cost = _expressions[f-_filters.size()].num_leaves();
+            }
+            rank[f] = (1 - selectivity) / cost;
+        }
+        std::stable_sort(order.begin(), order.end(), [&rank](size_t a, size_t b){ return rank[a]>rank[b]; });
+        return order;
+    };
+
+    size_t num_chunks = table->column(0)->num_chunks();
+    std::vector<std::vector<std::shared_ptr<arrow::Array>>> chunks_filters_boolean_masks(num_chunks); // for each chunk, all filter masks 
+    std::vector<arrow::Status> chunks_status(num_chunks);
+    masks.resize(num_chunks);
+
+    ThreadPool::instance().parallel_for(num_chunks, [&](size_t i){
+        chunks_status[i] = [&]() -> arrow::Status {
+            // all rows of fully matching chunks qualify, skip filter evaluation
+            if(_fully_matching_chunks[i] || predicates.empty()){
+                masks[i] = nullptr;
+                return arrow::Status::OK();
+            }
+
+            if(adaptive){
+                // survivors are kept as bitmap while dense, and as selection vector once sparse
+                std::vector<size_t> order = filter_order();
+                int64_t length = table->column(0)->chunk(i)->length();
+                std::shared_ptr<arrow::Array> mask;
+                std::shared_ptr<arrow::Array> selection;
+                for(size_t k=0; k<order.size(); k++){
+                    size_t f = order[k];
+                    ARROW_ASSIGN_OR_RAISE(auto boolean_mask, evaluate_filter(f, i, selection));
+                    int64_t true_count = std::static_pointer_cast<arrow::BooleanArray>(boolean_mask)->true_count();
+                    rows_evaluated[f] += boolean_mask->length();
+                    rows_passed[f] += true_count;
+
+                    arrow::Datum datum;
+                    int64_t num_survivors;
+                    if(selection!=nullptr){
+                        ARROW_ASSIGN_OR_RAISE(datum, arrow::compute::CallFunction("array_filter", {selection, boolean_mask}));
+                        selection = std::move(datum).make_array();
+                        num_survivors = selection->length();
+                    }
+                    else if(mask==nullptr){
+                        mask = boolean_mask;
+                        num_survivors = true_count;
                     }
-                    case dataType::double_:{
-                        constant = arrow::MakeScalar<double>(std::stod(filter.constant_or_column));
+                    else{
+                        ARROW_ASSIGN_OR_RAISE(datum, arrow::compute::CallFunction("and", {mask, boolean_mask}));
+                        mask = std::move(datum).make_array();
+                        num_survivors = std::static_pointer_cast<arrow::BooleanArray>(mask)->true_count();
+                    }
+
+                    if(num_survivors==0){
                         break;
                     }
+                    if(selection==nullptr && k+1<order.size() && num_survivors<_selection_vector_threshold*length){
+                        ARROW_ASSIGN_OR_RAISE(datum, arrow::compute::CallFunction("indices_nonzero", {mask}));
+                        selection = std::move(datum).make_array();
+                    }
+                }
+                if(selection!=nullptr){
+                    masks[i] = selection;
+                    return arrow::Status::OK();
                 }
-                ARROW_ASSIGN_OR_RAISE(boolean_mask_datum,arrow::compute::CallFunction(get_arrow_compute_operator(filter.operator_), {column_array, constant}));
+                ARROW_ASSIGN_OR_RAISE(masks[i], sparse_selection(mask));
+                return arrow::Status::OK();
             }
-            filter.boolean_mask = std::move(boolean_mask_datum).make_array();
-            filters_boolean_masks.push_back(filter.boolean_mask);
 
-            // filter metadata will only be written to sdc metadata, if currently using primary index
-            auto st = arrow::compute::CallFunction("array_filter", {filter.boolean_mask, filter.boolean_mask});
-            filter.true_count = st.ValueOrDie().make_array()->length();
-            filter.false_count = filter.boolean_mask->length() - filter.true_count;
-        }
-        chunks_filters_boolean_masks.push_back(filters_boolean_masks);
+            std::vector<std::shared_ptr<arrow::Array>>& filters_boolean_masks = chunks_filters_boolean_masks[i];
+            for(size_t f: predicates){
+                ARROW_ASSIGN_OR_RAISE(auto boolean_mask, evaluate_filter(f, i, nullptr));
+                filters_boolean_masks.push_back(boolean_mask);
+            }
+
+            // combine filters
+            masks[i] = filters_boolean_masks[0];
+            for(size_t f=1; f<filters_boolean_masks.size(); f++){
+                arrow::Datum boolean_mask_datum;
+                ARROW_ASSIGN_OR_RAISE(boolean_mask_datum,arrow::compute::CallFunction("and", {masks[i], filters_boolean_masks[f]}));
+                masks[i] = std::move(boolean_mask_datum).make_array();
+            }
+            ARROW_ASSIGN_OR_RAISE(masks[i], sparse_selection(masks[i]));
+            return arrow::Status::OK();
+        }();
+    });
+    for(const auto& st: chunks_status){
+        ARROW_RETURN_NOT_OK(st);
     }
 
-    // resize to num_chunks
-    masks.resize(chunks_filters_boolean_masks.size());
+    if(adaptive){
+        // statistics of repeated queries are not recorded, counts only cover the rows each filter was evaluated on
+        for(size_t f=0; f<_filters.size(); f++){
+            _filters[f].true_count = rows_passed[f];
+            _filters[f].false_count = rows_evaluated[f] - rows_passed[f];
+        }
+        return arrow::Status::OK();
+    }
 
-    arrow::Datum boolean_mask_datum;
-    // loop through chunks
-    for(size_t i=0; i<chunks_filters_boolean_masks.size(); i++){
-        masks[i] = chunks_filters_boolean_masks[i][0];
-        // loop through mask for each filter, combine filters
-        for(size_t j=1; j<chunks_filters_boolean_masks[i].size(); j++){
-        // for(const auto& filter_boolean_mask: chunks_filters_boolean_masks[i]){
-            ARROW_ASSIGN_OR_RAISE(boolean_mask_datum,arrow::compute::CallFunction("and", {masks[i], chunks_filters_boolean_masks[i][j]}));
-            masks[i] = std::move(boolean_mask_datum).make_array();
+    // filter statistics over all chunks, boolean masks are only kept if the execution records them
+    for(size_t f=0; f<_filters.size(); f++){
+        Filter& filter = _filters[f];
+        filter.true_count = 0;
+        filter.false_count = 0;
+        arrow::ArrayVector filter_chunks;
+        for(size_t i=0; i<num_chunks; i++){
+            if(_fully_matching_chunks[i]){
+                int64_t length = table->column(0)->chunk(i)->length();
+                filter.true_count += length;
+                if(_record_masks){
+                    ARROW_ASSIGN_OR_RAISE(auto all_true, arrow::MakeArrayFromScalar(arrow::BooleanScalar(true), length));
+                    filter_chunks.push_back(all_true);
+                }
+                continue;
+            }
+            auto boolean_mask = std::static_pointer_cast<arrow::BooleanArray>(chunks_filters_boolean_masks[i][f]);
+            filter.true_count += boolean_mask->true_count();
+            filter.false_count += boolean_mask->length() - boolean_mask->true_count();
+            filter_chunks.push_back(boolean_mask);
+        }
+        if(_record_masks){
+            ARROW_ASSIGN_OR_RAISE(filter.boolean_mask, arrow::Concatenate(filter_chunks));
         }
     }
 
     return arrow::Status::OK();
 }
 
-std::string Dataframe::get_arrow_compute_operator(std::string filter_operator){
-    std::string result;
-    if(filter_operator=="=="){
-        result = "equal";
-    }
-    else if(filter_operator=="<"){
-        result = "less";
-    }
-    else if(filter_operator==">"){
-        result = "greater";
-    }
-    else if(filter_operator=="<="){
-        result = "less_equal";
-    }
-    else if(filter_operator==">="){
-        result = "greater_equal";
+// sparse boolean masks are replaced by a selection vector (sorted row indices), so that projections
+// gather only the selected rows instead of scanning the whole chunk
+arrow::Result<std::shared_ptr<arrow::Array>> Dataframe::sparse_selection(const std::shared_ptr<arrow::Array>& mask){
+    if(mask==nullptr){
+        return mask;
     }
-    else if(filter_operator=="!="){
-        result = "not_equal";
+    int64_t true_count = std::static_pointer_cast<arrow::BooleanArray>(mask)->true_count();
+    if(true_count>=_selection_vector_threshold*mask->length()){
+        return mask;
     }
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum selection, arrow::compute::CallFunction("indices_nonzero", {mask}));
+    return std::move(selection).make_array();
+}
 
-    return result;
+void Dataframe::set_selection_vector_threshold(double threshold){
+    assert(threshold>=0 && threshold<=1);
+    _selection_vector_threshold = threshold;
+}
+
+void Dataframe::set_workload_sampling(double fraction, int min_executions){
+    assert(fraction>=0 && fraction<=1 && min_executions>=0);
+    _mask_sample_fraction = fraction;
+    _mask_min_executions = min_executions;
+}
+
+void Dataframe::set_workload_summary(size_t max_filters, size_t max_queries){
+    assert(max_filters>0 && max_queries>0);
+    _max_workload_filters = max_filters;
+    _max_workload_queries = max_queries;
+}
+
+void Dataframe::set_workload_decay(double half_life, double window){
+    assert(half_life>=0 && window>=0);
+    _workload_half_life = half_life;
+    _workload_window = window;
+}
+
+std::string Dataframe::get_arrow_compute_operator(std::string filter_operator){
+    return arrow_compute_operator(filter_operator);
 }
 
 void Dataframe::projection(std::vector<std::string> columns){
@@ -224,159 +692,400 @@ void Dataframe::projection(std::vector<std::string> columns){
     }
 }
 
+void Dataframe::projection(std::string name, Term term){
+    term.columns(_required_columns);
+    _derived_projections.push_back({name, term});
+}
+
 void Dataframe::filter(std::string column, std::string operator_, std::string constant, bool is_col){
+    // the column type is needed to parse the constant
+    if(_table_metadata==nullptr){
+        _table_metadata = load_metadata();
+    }
     _required_columns.push_back(column);
     _filters.push_back(Filter(column, operator_, constant, is_col, get_col_dataType(column)));
 }
 
-json Dataframe::load_index(int use_index){
-    json indexes = _metadata["indexes"];
-    if(indexes.size()==1 || use_index==1){
+void Dataframe::parameter(std::string column, std::string operator_){
+    if(_table_metadata==nullptr){
+        _table_metadata = load_metadata();
+    }
+    // the constant is parsed when bound
+    Filter filter;
+    filter.column = column;
+    filter.operator_ = operator_;
+    filter.is_col = false;
+    filter.type = get_col_dataType(column);
+    _required_columns.push_back(column);
+    _parameters.push_back(_filters.size());
+    _filters.push_back(filter);
+}
+
+void Dataframe::bind(std::vector<std::string> constants){
+    if(constants.size()!=_parameters.size()){
+        throw std::invalid_argument("bind: " + std::to_string(_parameters.size()) + " parameters, " + std::to_string(constants.size()) + " constants given");
+    }
+    for(size_t p=0; p<_parameters.size(); p++){
+        Filter& filter = _filters[_parameters[p]];
+        filter = Filter(filter.column, filter.operator_, constants[p], false, filter.type);
+    }
+}
+
+// a parameter without a constant would be compared with a null scalar
+void Dataframe::check_parameters_bound(){
+    for(size_t parameter: _parameters){
+        if(_filters[parameter].scalar==nullptr){
+            throw std::logic_error("parameter on column " + _filters[parameter].column + " is not bound");
+        }
+    }
+}
+
+void Dataframe::prepare(){
+    _table_metadata = load_metadata();
+    _prepared_selections.clear();
+    for(const auto& metadata_index: _table_metadata->indexes){
+        std::shared_ptr<const PreparedIndex> index = Catalog::instance().index(metadata_index);
+        _prepared_selections.push_back(prune_blocks(BlockSelection::all_blocks(index), filterSet::constant_filters));
+    }
+    _is_prepared = true;
+}
+
+void Dataframe::filter(Expression expression){
+    // keep simple conjuncts as filters, so that they are recorded in the workload and used for partitioning
+    if(expression.type==expressionType::comparison){
+        filter(expression.column, expression.operator_, expression.constants[0], expression.is_col);
+    }
+    else if(expression.type==expressionType::between){
+        filter(expression.column, ">=", expression.constants[0]);
+        filter(expression.column, "<=", expression.constants[1]);
+    }
+    else if(expression.type==expressionType::in && expression.constants.size()==1){
+        filter(expression.column, "==", expression.constants[0]);
+    }
+    else if(expression.type==expressionType::and_){
+        for(const auto& child: expression.children){
+            filter(child);
+        }
+    }
+    else{
+        // constants are parsed as the column types once, like the constants of filters
+        if(_table_metadata==nullptr){
+            _table_metadata = load_metadata();
+        }
+        expression.parse_constants([this](const std::string& column){ return get_col_dataType(column); });
+        expression.columns(_required_columns);
+        _expressions.push_back(expression);
+    }
+}
+
+// merges the comparisons with constants on each column into one interval, evaluated as a single range check
+// if at least two comparisons were merged. Detects conjunctions which no row can satisfy.
+void Dataframe::normalize_filters(){
+    _intervals.clear();
+    _is_contradiction = false;
+    std::vector<Interval> intervals;
+    for(size_t f=0; f<_filters.size(); f++){
+        const Filter& filter = _filters[f];
+        // strings have no numeric intervals
+        if(filter.is_col || filter.operator_=="!=" || filter.type==dataType::string){
+            continue;
+        }
+        auto interval = std::find_if(intervals.begin(), intervals.end(), [&filter](const Interval& i){ return i.column==filter.column; });
+        if(interval==intervals.end()){
+            intervals.push_back(Interval(filter.column, filter.type));
+            interval = intervals.end()-1;
+        }
+        interval->intersect(filter.operator_, filter.value);
+        interval->filters.push_back(f);
+    }
+
+    for(auto& interval: intervals){
+        if(interval.is_empty()){
+            _is_contradiction = true;
+        }
+        for(const auto& filter: _filters){
+            if(filter.column==interval.column && !filter.is_col && filter.operator_=="!=" && interval.is_point(filter.value)){
+                _is_contradiction = true;
+            }
+        }
+        if(interval.filters.size()>1){
+            _intervals.push_back(interval);
+        }
+    }
+}
+
+// result of a query without matching rows. An empty chunk of every column of the table metadata, typed as
+// loaded blocks are (string columns dictionary encoded), goes through the projections, so that derived
+// projections get the type of their term as in a result with rows
+std::shared_ptr<arrow::Table> Dataframe::empty_result(){
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+    const TableSchema& schema = _table_metadata->schema;
+    for(const auto& column: schema.columns()){
+        std::shared_ptr<arrow::DataType> type = schema.arrow_schema()->field(column.ordinal)->type();
+        if(column.type==dataType::string){
+            type = arrow::dictionary(arrow::int32(), type);
+        }
+        fields.push_back(arrow::field(column.name, type));
+        columns.push_back(arrow::MakeEmptyArray(type).ValueOrDie());
+    }
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(arrow::schema(fields), columns);
+    return apply_projections(table, {nullptr});
+}
+
+BlockSelection Dataframe::load_index(int use_index){
+    const std::vector<IndexMetadata>& indexes = _table_metadata->indexes;
+    if(use_index==indexType::automatic && indexes.size()>1){
+        return choose_index();
+    }
+    else if(indexes.size()==1 || use_index==indexType::primary){
         _using_primary_index = true;
-        for(auto index: indexes){
-            if(index["type"]=="primary"){
-                std::ifstream f(index["filePath"]);
-                return json::parse(f);
+        _index_type = "primary";
+        for(const auto& index: indexes){
+            if(index.type=="primary"){
+                return select_blocks(index);
             }
         }       
         // should not reach this
         assert(1==2);
     }
-    else if(use_index==2){
-        // column partition index
-        json columnPartition;
-        for(auto& index: indexes){
-            if(index["type"]=="columnPartition"){
-                columnPartition = index;
-            }
+
+    std::string index_type = use_index==indexType::columnPartition ? "columnPartition" : "qdTree";
+    assert(use_index==indexType::columnPartition || use_index==indexType::qdTree);
+    const IndexMetadata* metadata_index = nullptr;
+    for(const auto& index: indexes){
+        if(index.type==index_type){
+            metadata_index = &index;
         }
+    }
 
-        _using_primary_index = false;
-        std::ifstream f(columnPartition["filePath"]);
-        return json::parse(f);
+    // requested index does not exist or does not have all required columns
+    if(metadata_index==nullptr || !has_required_columns(*metadata_index)){
+        if(_verbose){
+            std::cout << "index " << index_type << " cannot answer query, choosing index automatically" << std::endl;
+        }
+        return choose_index();
     }
-    else{
-        assert(use_index==3);
-        // qd_tree index
-        json qd_tree;
-        for(auto& index: indexes){
-            if(index["type"]=="qdTree"){
-                qd_tree = index;
-            }
+
+    _using_primary_index = false;
+    _index_type = index_type;
+    return select_blocks(*metadata_index);
+}
+
+// blocks of the index which the query scans. The index comes from the catalog, which parses the file again
+// once its version changed. A prepared query prunes by its constant filters and expressions once per index
+// version and then only checks the kept blocks against the bound parameters
+BlockSelection Dataframe::select_blocks(const IndexMetadata& metadata_index){
+    std::shared_ptr<const PreparedIndex> index;
+    {
+        StageTimer timer(_profile[queryStage::index_load]);
+        index = Catalog::instance().index(metadata_index);
+    }
+    StageTimer timer(_profile[queryStage::pruning]);
+    if(!_is_prepared){
+        return prune_blocks(BlockSelection::all_blocks(index), filterSet::all_filters);
+    }
+    auto prepared = std::find_if(_prepared_selections.begin(), _prepared_selections.end(), [&index](const BlockSelection& selection){
+        return selection.index->file_path==index->file_path;
+    });
+    if(prepared==_prepared_selections.end()){
+        _prepared_selections.push_back(prune_blocks(BlockSelection::all_blocks(index), filterSet::constant_filters));
+        prepared = _prepared_selections.end()-1;
+    }
+    // the index file was rewritten since, e.g. by an optimize of another query or process
+    if(prepared->index!=index){
+        *prepared = prune_blocks(BlockSelection::all_blocks(index), filterSet::constant_filters);
+    }
+    return prune_blocks(*prepared, filterSet::parameter_filters);
+}
+
+// blocks of the selection which the filter set keeps, fully matching if they were and all their rows satisfy the filter set
+BlockSelection Dataframe::prune_blocks(const BlockSelection& selection, filterSet filters){
+    const PreparedIndex& index = *selection.index;
+    BlockSelection result{selection.index, {}, {}};
+    for(size_t s=0; s<selection.blocks.size(); s++){
+        size_t b = selection.blocks[s];
+        if(!is_relevant_block(index, b, nullptr, filters)){
+            continue;
         }
+        result.blocks.push_back(b);
+        result.fully_matching.push_back(selection.fully_matching[s] && is_fully_matching_block(index, b, filters));
+    }
+    return result;
+}
 
-        // check if qdTree has all required columns
-        bool has_all_columns = true;
-        for(const auto& proj: _projections){
-            bool found = false;
-            for(const auto& col: qd_tree["columns"]){
-                if(proj==col["name"]){
-                    found = true;
-                    break;
-                }
-            }
-            if(!found){
-                has_all_columns = false;
-                break;
-            }
+// cost based index selection: for each index which has all columns required by the query,
+// estimate the bytes and rows scanned after block pruning and pick the cheapest one
+BlockSelection Dataframe::choose_index(){
+    BlockSelection chosen_selection;
+    int64_t chosen_bytes = -1;
+    int64_t chosen_rows = -1;
+    _index_selection = json::object();
+    _index_selection["candidates"] = json::array();
+    for(const auto& metadata_index: _table_metadata->indexes){
+        json candidate;
+        candidate["type"] = metadata_index.type;
+        candidate["hasRequiredColumns"] = has_required_columns(metadata_index);
+        if(!candidate["hasRequiredColumns"]){
+            _index_selection["candidates"].push_back(candidate);
+            continue;
+        }
+
+        BlockSelection selection = select_blocks(metadata_index);
+        int64_t bytes = 0;
+        int64_t rows = 0;
+        for(size_t b: selection.blocks){
+            bytes += selection.index->block_bytes(b);
+            rows += block_num_rows(*selection.index, b);
+        }
+        candidate["estimatedBytes"] = bytes;
+        candidate["estimatedRows"] = rows;
+        _index_selection["candidates"].push_back(candidate);
+
+        if(chosen_bytes<0 || bytes<chosen_bytes || (bytes==chosen_bytes && rows<chosen_rows)){
+            chosen_bytes = bytes;
+            chosen_rows = rows;
+            chosen_selection = std::move(selection);
+            _index_type = metadata_index.type;
         }
-        _using_primary_index = false;
-        std::ifstream f(qd_tree["filePath"]);
-        return json::parse(f);
     }
+    // primary index always has all columns
+    assert(chosen_bytes>=0);
+    _using_primary_index = _index_type=="primary";
+    _index_selection["chosen"] = _index_type;
+
+    if(_verbose){
+        std::cout << "index selection: " << _index_selection.dump() << std::endl;
+    }
+    return chosen_selection;
 }
 
-std::shared_ptr<arrow::Table> Dataframe::load_data(json index){
-    assert(_table_name==index["table"]);
+// primary and column partition blocks contain all columns, qd tree blocks only the columns used by the workload
+bool Dataframe::has_required_columns(const IndexMetadata& metadata_index){
+    if(!metadata_index.has_columns){
+        return true;
+    }
+    std::vector<std::string> required_columns = _required_columns;
+    for(const auto& filter: _filters){
+        if(filter.is_col){
+            required_columns.push_back(filter.constant_or_column);
+        }
+    }
+    for(const auto& column: required_columns){
+        if(std::find(metadata_index.columns.begin(), metadata_index.columns.end(), column)==metadata_index.columns.end()){
+            return false;
+        }
+    }
+    return true;
+}
 
-    // load all tables
-    std::vector<std::shared_ptr<arrow::Table>> data_blocks;
-    for(auto& block: index["dataBlocks"]){
-        // check: does data block contain data which the query needs?
-        bool is_relevant = true;
-        for(const auto& range: block["ranges"]){
-            // find filters on same column
-            for(const auto& filter: _filters){
-                if(range["column"]==filter.column && !filter.is_col){
-                    // check if data block and filter have overlap
-                    switch(string_to_dataType(range["colDataType"])){
-
-                        case dataType::int64:{
-                            if(filter.operator_=="<" && range["min"]!=""
-                                && (std::stoi(range["min"].get<std::string>()) >= std::stoi(filter.constant_or_column)
-                                || (std::stoi(range["min"].get<std::string>()) > std::stoi(filter.constant_or_column)-1 && !range["minInclusive"]))){
-                                is_relevant = false;
-
-                            }
-                            else if(filter.operator_=="<=" && range["min"]!="" 
-                                && (std::stoi(range["min"].get<std::string>()) > std::stoi(filter.constant_or_column)
-                                || (std::stoi(range["min"].get<std::string>()) >= std::stoi(filter.constant_or_column) && !range["minInclusive"]))){
-                                is_relevant = false;
-                            }
-                            else if(filter.operator_==">" && range["max"]!="" 
-                                && (std::stoi(range["max"].get<std::string>()) <= std::stoi(filter.constant_or_column)
-                                || (std::stoi(range["max"].get<std::string>()) < std::stoi(filter.constant_or_column)+1 && !range["maxInclusive"]))){
-                                is_relevant = false;
-                            }
-                            else if(filter.operator_==">=" && range["max"]!="" 
-                                && (std::stoi(range["max"].get<std::string>()) < std::stoi(filter.constant_or_column)
-                                || (std::stoi(range["max"].get<std::string>()) <= std::stoi(filter.constant_or_column) && !range["maxInclusive"]))){
-                                is_relevant = false;
-                            }
-                            else if(filter.operator_=="==" && 
-                                ((range["max"]!="" && std::stoi(range["max"].get<std::string>()) < std::stoi(filter.constant_or_column))
-                                || (range["max"]!="" && std::stoi(range["max"].get<std::string>()) <= std::stoi(filter.constant_or_column) && !range["maxInclusive"])
-                                || (range["min"]!="" && std::stoi(range["min"].get<std::string>()) > std::stoi(filter.constant_or_column))
-                                || (range["min"]!="" && std::stoi(range["min"].get<std::string>()) >= std::stoi(filter.constant_or_column) && !range["minInclusive"]))){
-                                is_relevant = false;
-                            }
-                            break;
-                        }
-                        case dataType::double_:{
-                            if(filter.operator_=="<" && range["min"]!="" 
-                                && std::stod(range["min"].get<std::string>()) >= std::stod(filter.constant_or_column)){
-                                is_relevant = false;
-                            }
-                            else if(filter.operator_=="<=" && range["min"]!="" 
-                                && (std::stod(range["min"].get<std::string>()) > std::stod(filter.constant_or_column)
-                                || (std::stod(range["min"].get<std::string>()) >= std::stod(filter.constant_or_column) && !range["minInclusive"]))){
-                                is_relevant = false;
-                            }
-                            else if(filter.operator_==">" && range["max"]!="" && std::stod(range["max"].get<std::string>()) <= std::stod(filter.constant_or_column)){
-                                is_relevant = false;
-                            }
-                            else if(filter.operator_==">=" && range["max"]!="" 
-                                && (std::stod(range["max"].get<std::string>()) < std::stod(filter.constant_or_column)
-                                || (std::stod(range["max"].get<std::string>()) <= std::stod(filter.constant_or_column) && !range["maxInclusive"]))){
-                                is_relevant = false;
-                            }
-                            else if(filter.operator_=="==" 
-                                && ((range["max"]!="" && std::stod(range["max"].get<std::string>()) < std::stod(filter.constant_or_column)) 
-                                || (range["max"]!="" && std::stod(range["max"].get<std::string>()) <= std::stod(filter.constant_or_column) && !range["maxInclusive"]) 
-                                || (range["min"]!="" && std::stod(range["min"].get<std::string>()) > std::stod(filter.constant_or_column))
-                                || (range["min"]!="" && std::stod(range["min"].get<std::string>()) >= std::stod(filter.constant_or_column) && !range["minInclusive"]))){
-                                is_relevant = false;
-                            }
-                            break;
-                        }
-                        default:{
-                            // should not reach this
-                            assert(1==2);
-                        }
-                    }
-                }
-                if(!is_relevant){
-                    break;
-                }
+int64_t Dataframe::block_num_rows(const PreparedIndex& index, size_t b){
+    // primary index blocks do not store their number of rows
+    if(index.block_rows(b)>=0){
+        return index.block_rows(b);
+    }
+    return _table_metadata->num_rows / int64_t(index.num_blocks());
+}
+
+// the filter is pruned by in the set: parameters are only in the parameter set, other filters in the constant set
+bool Dataframe::is_in_filter_set(size_t f, filterSet filters){
+    if(filters==filterSet::all_filters){
+        return true;
+    }
+    bool is_parameter = std::find(_parameters.begin(), _parameters.end(), f)!=_parameters.end();
+    return is_parameter==(filters==filterSet::parameter_filters);
+}
+
+// check: does data block contain data which the filter set needs?
+// if not, reason is set to the block range and filter which excluded it
+bool Dataframe::is_relevant_block(const PreparedIndex& index, size_t b, json* reason, filterSet filters){
+    BlockRanges ranges = index.block_ranges(b);
+    bool is_relevant = true;
+    for(size_t r=0; r<ranges.size(); r++){
+        std::string_view column = ranges.column(r);
+        // find filters on same column
+        for(size_t f=0; f<_filters.size(); f++){
+            const Filter& filter = _filters[f];
+            if(column==filter.column && !filter.is_col && is_in_filter_set(f, filters)){
+                // check if data block and filter have overlap
+                is_relevant = ranges[r].compare(filter.operator_, filter.value)!=rangeMatch::never;
             }
             if(!is_relevant){
+                if(reason!=nullptr){
+                    (*reason)["range"] = index.ranges_json(b)[r];
+                    (*reason)["filter"] = {{"column", filter.column}, {"operator", filter.operator_}, {"constant", filter.constant_or_column}};
+                }
                 break;
             }
         }
-        if(is_relevant){
-            data_blocks.push_back(load_parquet(block["filePath"]));
+        if(!is_relevant){
+            break;
+        }
+    }
+    if(!is_relevant){
+        return false;
+    }
+
+    // expressions are checked against all ranges of the block at once, so that disjunctions can exclude it as well
+    if(_expressions.empty() || filters==filterSet::parameter_filters){
+        return true;
+    }
+    for(const auto& expression: _expressions){
+        if(expression.evaluate_ranges(ranges)==rangeMatch::never){
+            if(reason!=nullptr){
+                (*reason)["ranges"] = index.ranges_json(b);
+                (*reason)["expression"] = expression.to_string();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+// all rows of a data block satisfy the filter set, if the block range of every filtered column lies within the filter
+bool Dataframe::is_fully_matching_block(const PreparedIndex& index, size_t b, filterSet filters){
+    BlockRanges ranges = index.block_ranges(b);
+    for(size_t f=0; f<_filters.size(); f++){
+        const Filter& filter = _filters[f];
+        if(!is_in_filter_set(f, filters)){
+            continue;
+        }
+        if(filter.is_col){
+            return false;
+        }
+        size_t r = 0;
+        while(r<ranges.size() && ranges.column(r)!=filter.column){
+            r++;
+        }
+        if(r==ranges.size()){
+            return false;
+        }
+
+        bool contained = ranges[r].compare(filter.operator_, filter.value)==rangeMatch::always;
+        if(!contained){
+            return false;
+        }
+    }
+    if(_expressions.empty() || filters==filterSet::parameter_filters){
+        return true;
+    }
+    for(const auto& expression: _expressions){
+        if(expression.evaluate_ranges(ranges)!=rangeMatch::always){
+            return false;
         }
     }
+    return true;
+}
+
+std::shared_ptr<arrow::Table> Dataframe::load_data(const BlockSelection& selection){
+    assert(_table_name==selection.index->table);
+
+    // load the selected tables, remember for each chunk if filters need to be evaluated
+    std::vector<std::shared_ptr<arrow::Table>> data_blocks;
+    _fully_matching_chunks.clear();
+    for(size_t s=0; s<selection.blocks.size(); s++){
+        data_blocks.push_back(load_block(selection, s));
+    }
 
     // merge tables
     arrow::Result<std::shared_ptr<arrow::Table>> result = arrow::ConcatenateTables(data_blocks);
@@ -386,15 +1095,47 @@ std::shared_ptr<arrow::Table> Dataframe::load_data(json index){
     return result.ValueOrDie();
 }
 
+// loads the s-th selected data block, its chunks are appended to the fully matching chunks
+std::shared_ptr<arrow::Table> Dataframe::load_block(const BlockSelection& selection, size_t s){
+    std::shared_ptr<arrow::Table> table = load_parquet(std::string(selection.index->block_path(selection.blocks[s])));
+    _fully_matching_chunks.insert(_fully_matching_chunks.end(), table->column(0)->num_chunks(), selection.fully_matching[s]);
+    return table;
+}
+
 std::shared_ptr<arrow::Table> Dataframe::load_parquet(std::string file_path){
-    add_latency(file_path);
-    std::shared_ptr<arrow::io::ReadableFile> infile;
-    PARQUET_ASSIGN_OR_THROW(infile,arrow::io::ReadableFile::Open(file_path,arrow::default_memory_pool()));
+    // read raw file (io), then decode parquet from memory (decode)
+    std::shared_ptr<arrow::Buffer> file_buffer;
+    {
+        StageTimer timer(_profile[queryStage::io]);
+        add_latency(file_path);
+        std::shared_ptr<arrow::io::ReadableFile> infile;
+        PARQUET_ASSIGN_OR_THROW(infile,arrow::io::ReadableFile::Open(file_path,arrow::default_memory_pool()));
+        int64_t file_size;
+        PARQUET_ASSIGN_OR_THROW(file_size, infile->GetSize());
+        PARQUET_ASSIGN_OR_THROW(file_buffer, infile->Read(file_size));
+        _profile[queryStage::io].bytes_read += file_buffer->size();
+    }
 
-    std::unique_ptr<parquet::arrow::FileReader> reader;
-    PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
     std::shared_ptr<arrow::Table> table;
-    PARQUET_THROW_NOT_OK(reader->ReadTable(&table));
+    {
+        StageTimer timer(_profile[queryStage::decode]);
+        auto buffer_reader = std::make_shared<arrow::io::BufferReader>(file_buffer);
+        parquet::arrow::FileReaderBuilder builder;
+        PARQUET_THROW_NOT_OK(builder.Open(buffer_reader));
+        // string columns are kept dictionary encoded, filters on them are evaluated once per distinct value
+        parquet::ArrowReaderProperties properties;
+        const parquet::SchemaDescriptor* parquet_schema = builder.raw_reader()->metadata()->schema();
+        for(int i=0; i<parquet_schema->num_columns(); i++){
+            if(parquet_schema->Column(i)->physical_type()==parquet::Type::BYTE_ARRAY){
+                properties.set_read_dictionary(i, true);
+            }
+        }
+        std::unique_ptr<parquet::arrow::FileReader> reader;
+        PARQUET_THROW_NOT_OK(builder.properties(properties)->Build(&reader));
+        PARQUET_THROW_NOT_OK(reader->ReadTable(&table));
+        _profile[queryStage::decode].bytes_read += file_buffer->size();
+        _profile[queryStage::decode].rows_out += table->num_rows();
+    }
 
     if(_verbose){
         std::cout << "Loaded " << table->num_rows() << " rows in " << table->num_columns() << " columns." << std::endl;
@@ -406,62 +1147,37 @@ std::shared_ptr<arrow::Table> Dataframe::load_parquet(std::string file_path){
     return table;
 }
 
-json Dataframe::load_metadata(){
-    std::ifstream f("../data/metadata.json");
-    json metadata_json = json::parse(f);
-    for(auto& table: metadata_json["tables"]){
-        if(table["name"]==_table_name){
-            return table;
-        }
-    } 
-    if(_verbose){
+// table metadata of the catalog, nullptr if the table does not exist
+std::shared_ptr<const TableMetadata> Dataframe::load_metadata(){
+    std::shared_ptr<const TableMetadata> table = Catalog::instance().table(_table_name, _data_directory);
+    if(table==nullptr && _verbose){
         std::cout << "table " + _table_name + " not found" << std::endl;
     }
-    return json();
+    return table;
 }
 
-void Dataframe::write_boolean_filter(Filter& filter, const std::string& filepath){
-    
-    std::ofstream out_file;
-    // trunc will clear the file
-    out_file.open(filepath, out_file.binary | out_file.trunc);
-    if(!out_file.is_open()){
-        std::cerr << "Failed to open " << filepath << std::endl;
+// table metadata and the workload entries of the query and its filters, from a single refresh of the catalog
+WorkloadSnapshot Dataframe::load_workload_snapshot(){
+    std::vector<std::string> filter_keys;
+    for(const auto& filter: _filters){
+        filter_keys.push_back(Workload::filter_key(filter.column, filter.operator_, filter.constant_or_column, filter.is_col));
     }
-    else{
-        auto array = std::static_pointer_cast<arrow::BooleanArray>(filter.boolean_mask);
-        size_t mask_length = filter.boolean_mask->length();
-        size_t num_bytes = mask_length/8 + (mask_length%8 != 0);
-        for(int i=0; i<num_bytes; i++){
-            // ch: 00000000
-            char ch = 0;
-            for(int j=0; j<8; j++){
-                int k = i * 8 + j;
-                if(k<mask_length){
-                    ch |= (array->Value(k) << (8-j-1));
-                    // std::cout << std::bitset<8>(ch) << std::endl;
-                }
-            }
-            out_file.write(&ch, sizeof(ch));
-        }
+    WorkloadSnapshot snapshot = Catalog::instance().snapshot(_table_name, _data_directory, get_query_id(), filter_keys);
+    if(snapshot.table==nullptr && _verbose){
+        std::cout << "table " + _table_name + " not found" << std::endl;
     }
+    return snapshot;
 }
 
-// add each used filter to workload, add boolean masks for each filter
+// add each used filter to workload, add boolean masks for each filter if the execution records them.
+// the execution is appended to the workload log, metadata.json is only rewritten by its compaction
 void Dataframe::update_metadata(){
 
     // update metadata
     std::string query_id = get_query_id();
-    bool query_found = false;
-    for(auto& workload: _metadata["workload"]){
-        if(workload["queryID"]==query_id){
-            int executionCount = workload["executionCount"];
-            workload["executionCount"] = ++executionCount;
-            query_found = true;
-            break;
-        }
-    }
-    if(!query_found){
+    json record;
+    record["queryID"] = query_id;
+    if(!is_query_in_workload()){
         json metadata_workload;
         metadata_workload["queryID"] = query_id;
         metadata_workload["executionCount"] = 1;
@@ -482,74 +1198,120 @@ void Dataframe::update_metadata(){
             metadata_filter["isCol"] = filter.is_col;
             metadata_filter["trueCount"] = filter.true_count;
             metadata_filter["falseCount"] = filter.false_count;
-            if(_using_primary_index){
-                // write arrow boolean array to disk
-                std::string boolean_mask_file = _data_directory+"/boolean_filter_"+filter.column+filter.operator_+filter.constant_or_column;
-                write_boolean_filter(filter, boolean_mask_file); 
-                metadata_filter["booleanMask"] = boolean_mask_file;
-            }
             metadata_filters.push_back(metadata_filter);
         }
 
         metadata_workload["filters"] = metadata_filters;
         metadata_workload["projections"] = metadata_projections;
-            
-        _metadata["workload"].push_back(metadata_workload);
+        for(const auto& expression: _expressions){
+            metadata_workload["expressions"].push_back(expression.to_json());
+        }
+        for(const auto& derived: _derived_projections){
+            json metadata_derived;
+            metadata_derived["name"] = derived.first;
+            metadata_derived["expression"] = derived.second.to_string();
+            std::vector<std::string> columns;
+            derived.second.columns(columns);
+            metadata_derived["columns"] = columns;
+            metadata_workload["derivedProjections"].push_back(metadata_derived);
+        }
+
+        record = metadata_workload;
+    }
+    record["executedAt"] = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    WorkloadLog log(_table_name, _data_directory);
+    log.append(record);
+
+    // boolean masks are written by the background recorder, a second record attaches them to the workload entry.
+    // The copied filters keep the masks alive. A concurrent execution of the same shape may have scheduled them already
+    if(_record_masks){
+        log.append_masks_deferred(query_id, [query_id, filters=_filters, data_directory=_data_directory](){
+            json mask_record;
+            mask_record["queryID"] = query_id;
+            for(const auto& filter: filters){
+                // write arrow boolean array to disk
+                std::string boolean_mask_file = data_directory+"/boolean_filter_"+filter.column+filter.operator_+filter.constant_or_column;
+                BooleanMaskFile::write(filter.boolean_mask, boolean_mask_file);
+                mask_record["booleanMasks"][Workload::filter_key(filter.column, filter.operator_, filter.constant_or_column, filter.is_col)] = boolean_mask_file;
+            }
+            return mask_record;
+        });
     }
+}
 
-    // read in file, replace table metadata
-    std::ifstream f("../data/metadata.json");
-    json metadata_json = json::parse(f);
-    for(auto& table: metadata_json["tables"]){
-        if(table["name"]==_table_name){
-            table = _metadata;
-            break;
+bool Dataframe::is_query_in_workload(){
+    return !_workload_snapshot.query.is_null();
+}
+
+// boolean masks are recorded once per query: for a fixed fraction of query shapes (by their fingerprint),
+// or at the execution which reaches the minimum number of executions unless that is 0. Shapes whose masks
+// are still being written by this process are skipped
+bool Dataframe::is_mask_sampled(){
+    if(!_using_primary_index || _filters.empty()){
+        return false;
+    }
+    std::string query_id = get_query_id();
+    if(WorkloadLog(_table_name, _data_directory).masks_pending(query_id)){
+        return false;
+    }
+    const json& query = _workload_snapshot.query;
+    int64_t executions = 1;
+    if(!query.is_null()){
+        if(query["filters"][0].contains("booleanMask")){
+            return false;
         }
-    } 
+        executions += query["executionCount"].get<int64_t>();
+    }
+    bool reached_executions = _mask_min_executions>0 && executions>=_mask_min_executions;
+    return reached_executions || std::stoull(query_id.substr(0, 8), nullptr, 16) < _mask_sample_fraction*4294967296.0;
+}
 
-    // write out updated metadata
-    std::ofstream o("../data/metadata.json");
-    o << std::setw(2) << metadata_json << std::endl;
+// true and false count of the same filter in a previously recorded query
+bool Dataframe::workload_filter_statistics(const Filter& filter, int64_t& true_count, int64_t& false_count){
+    std::string filter_key = Workload::filter_key(filter.column, filter.operator_, filter.constant_or_column, filter.is_col);
+    auto it = _workload_snapshot.filter_statistics.find(filter_key);
+    if(it==_workload_snapshot.filter_statistics.end()){
+        return false;
+    }
+    true_count = it->second.first;
+    false_count = it->second.second;
+    return true;
 }
 
+// 64 bit fingerprint (FNV-1a) of the canonical query: filters, expressions, projections and derived projections
+// are sorted, so queries which only differ in their order share the id. Parts are separated by a unit separator.
 std::string Dataframe::get_query_id(){
-    std::string query_id = _table_name;
-    for(auto filter: _filters){
-        query_id += filter.column + filter.operator_ + filter.constant_or_column;
+    std::vector<std::string> filters;
+    for(const auto& filter: _filters){
+        filters.push_back(Workload::filter_key(filter.column, filter.operator_, filter.constant_or_column, filter.is_col));
     }
-    for(auto projection: _projections){
-        query_id += projection;
+    std::vector<std::string> expressions;
+    for(const auto& expression: _expressions){
+        expressions.push_back(expression.to_string());
     }
-    return query_id;
-}
-
-std::shared_ptr<arrow::Array> Dataframe::read_boolean_filter(const std::string& filepath){
-    std::ifstream in_file;
-    std::shared_ptr<arrow::Array> boolean_filter;
-    auto builder = arrow::BooleanBuilder();
-    int num_valid_bits = _metadata["num_rows"];
-    in_file.open(filepath, in_file.binary);
-    if(!in_file.is_open()){
-        std::cerr << "Failed to open " << filepath << std::endl;
+    std::vector<std::string> projections = _projections;
+    for(const auto& derived: _derived_projections){
+        projections.push_back(derived.first + "=" + derived.second.to_string());
     }
-    else{
-        int bit_counter = 0;
-        while(in_file.peek()!=EOF){
-            char ch;
-            in_file.read(&ch, sizeof(ch));
-            for (int i=0; i<8; i++){
-                if(bit_counter<num_valid_bits){
-                    bool bit = (ch >> (8-1-i)) & 1U;
-                    arrow::Status a = builder.Append(bit);
-                    bit_counter++;
-                }
-            }
+
+    std::string canonical = _table_name;
+    for(auto* parts: {&filters, &expressions, &projections}){
+        std::sort(parts->begin(), parts->end());
+        canonical += '\x1e';
+        for(const auto& part: *parts){
+            canonical += part + '\x1d';
         }
     }
-    auto st = builder.Finish(&boolean_filter);
-    assert(st.ok());
 
-    return boolean_filter;
+    uint64_t hash = 14695981039346656037ULL;
+    for(unsigned char c: canonical){
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    std::ostringstream query_id;
+    query_id << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return query_id.str();
 }
 
 // Write out the data as a Parquet file
@@ -564,26 +1326,39 @@ arrow::Status Dataframe::write_parquet_file(const std::shared_ptr<arrow::Table>&
     return arrow::Status::OK();
 }
 
-void Dataframe::remove_index(std::string index_type){
+void Dataframe::remove_index(json& metadata, std::string index_type){
     // remove previous qd tree index
-    for(int i=0; i<_metadata["indexes"].size(); i++){
-        if(_metadata["indexes"][i]["type"]==index_type){
+    for(int i=0; i<metadata["indexes"].size(); i++){
+        if(metadata["indexes"][i]["type"]==index_type){
             // remove data blocks
-            std::ifstream f(_metadata["indexes"][i]["filePath"]);
+            std::ifstream f(metadata["indexes"][i]["filePath"]);
             json index = json::parse(f);
             for(auto dataBlock: index["dataBlocks"]){
                 std::filesystem::remove(std::string(dataBlock["filePath"]));
             }
             // remove index file
-            std::filesystem::remove(std::string(_metadata["indexes"][i]["filePath"]));
+            std::filesystem::remove(std::string(metadata["indexes"][i]["filePath"]));
+            std::filesystem::remove(BinaryIndex::binary_path(metadata["indexes"][i]["filePath"]));
             // remove qd index
-            _metadata["indexes"].erase(i);
+            metadata["indexes"].erase(i);
             break;
         }
     }
     std::filesystem::create_directories(_data_directory+"/"+index_type);
 }
 
+// replaces the JSON index file and then its binary index, each with an atomic rename, so that concurrent
+// queries read either the old or the complete new index
+void Dataframe::write_index_file(const json& index_file, const std::string& file_path){
+    std::ostringstream o;
+    o << std::setw(2) << index_file << std::endl;
+    std::string contents = o.str();
+    if(!write_file_atomically(file_path, {contents})){
+        std::cout << "index " << file_path << " could not be written" << std::endl;
+    }
+    BinaryIndex::write(index_file, BinaryIndex::binary_path(file_path));
+}
+
 json Dataframe::qdTree_metadata_file(QDTree qd, std::shared_ptr<arrow::Table> table){
     json qd_index;
     qd_index["table"] = _table_name;
@@ -685,53 +1460,102 @@ json Dataframe::metadata_columnPartition_index(ColPartition cp){
 }
 
 void Dataframe::optimize(std::string partition_column, int min_leaf_size){
-    // get table meta data
-    _metadata = load_metadata();
+    // get table meta data from the compacted workload, the new layout invalidates a prepared plan
+    WorkloadLog(_table_name, _data_directory).compact();
+    _table_metadata = load_metadata();
+    json metadata = _table_metadata->metadata;
+    _is_prepared = false;
+    _prepared_selections.clear();
 
     // get all filters and projections for qd tree
     std::vector<Filter> workload_filters;
+    std::vector<std::vector<Filter>> workload_queries;
+    std::vector<double> workload_weights;
     std::vector<std::string> workload_projections;
-    for(const auto& metadata_workload: _metadata["workload"]){
-        for(const auto& metadata_filter: metadata_workload["filters"]){
+    json workload = Catalog::instance().workload(_table_name, _data_directory);
+    json current_workload = json::array();
+    std::vector<double> current_weights;
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    for(const auto& metadata_workload: workload){
+        // queries only executed outside of the window are not part of the current workload
+        double weight = Workload::weight(metadata_workload, now, _workload_half_life, _workload_window);
+        if(weight<=0){
+            continue;
+        }
+        current_workload.push_back(metadata_workload);
+        current_weights.push_back(weight);
+
+        for(const auto& metadata_projection: metadata_workload["projections"]){
+            // load workload filters into Arrow arrays 
+            if(std::find(workload_projections.begin(), workload_projections.end(), metadata_projection["name"])==workload_projections.end()){
+                workload_projections.push_back(metadata_projection["name"]);
+            }
+        }
+        // columns read by derived projections have to be stored in the qd tree blocks as well
+        for(const auto& metadata_derived: metadata_workload.value("derivedProjections", json::array())){
+            for(const auto& column: metadata_derived["columns"]){
+                if(std::find(workload_projections.begin(), workload_projections.end(), column)==workload_projections.end()){
+                    workload_projections.push_back(column);
+                }
+            }
+        }
+    }
+
+    // similar filters are merged, so that the cost of the qd tree does not grow with the size of the workload
+    WorkloadSummary summary(current_workload, current_weights, _max_workload_filters, _max_workload_queries);
+    if(_verbose){
+        std::cout << "workload summary: " << summary.report().dump() << std::endl;
+    }
+    for(const auto& query: summary.queries()){
+        // every query with parsed constants, weighs the cuts of the qd tree by its decayed executions
+        std::vector<Filter> query_filters;
+        for(const auto& metadata_filter: query.filters){
+            query_filters.push_back(Filter(metadata_filter["column"], metadata_filter["operator"], metadata_filter["constantOrColumn"], metadata_filter["isCol"], get_col_dataType(metadata_filter["column"])));
+        }
+        workload_queries.push_back(query_filters);
+        workload_weights.push_back(query.weight);
+
+        for(const auto& metadata_filter: query.filters){
             // load workload filters into Arrow arrays 
+            // boolean masks are only recorded for queries executed on the primary index
+            if(!metadata_filter.contains("booleanMask")){
+                continue;
+            }
             Filter filter(metadata_filter["column"], metadata_filter["operator"], metadata_filter["constantOrColumn"], metadata_filter["isCol"], get_col_dataType(metadata_filter["column"]));
             if(std::find(workload_filters.begin(), workload_filters.end(), filter)==workload_filters.end()){
                 filter.true_count = metadata_filter["trueCount"];
                 filter.false_count = metadata_filter["falseCount"];
-                filter.boolean_mask = read_boolean_filter(metadata_filter["booleanMask"]);
+                filter.boolean_mask = BooleanMaskFile::read(metadata_filter["booleanMask"], _table_metadata->num_rows);
                 workload_filters.push_back(filter);
             }
         }
-        for(const auto& metadata_projection: metadata_workload["projections"]){
-            // load workload filters into Arrow arrays 
-            if(std::find(workload_projections.begin(), workload_projections.end(), metadata_projection["name"])==workload_projections.end()){
-                workload_projections.push_back(metadata_projection["name"]);
-            }
-        }
+    }
+
+    if(workload_filters.empty()){
+        std::cout << "no workload filters with boolean masks to optimize for" << std::endl;
+        return;
     }
 
     // get table from primary index
-    json primary_index = load_index(true);
-    std::shared_ptr<arrow::Table> table = load_data(primary_index);
+    std::shared_ptr<arrow::Table> table = load_data(load_index(indexType::primary));
  
     // ---------- COLUMN PARTITION ---------- //
-    ColPartition colP = ColPartition(partition_column, workload_filters, _metadata);
+    ColPartition colP = ColPartition(partition_column, workload_filters, metadata);
 
-    remove_index("column_partition");
+    remove_index(metadata, "column_partition");
 
     json colP_index_file = colPartition_metadata_file(colP, table);
     
-    // write qd index metadata file
-    std::ofstream o(_data_directory+"/cp_index.json");
-    o << std::setw(2) << colP_index_file << std::endl;
+    // write column partition index file
+    write_index_file(colP_index_file, _data_directory+"/cp_index.json");
 
     // update metadata
     json metadata_indexes_cp = metadata_columnPartition_index(colP);
-    _metadata["indexes"].push_back(metadata_indexes_cp);
+    metadata["indexes"].push_back(metadata_indexes_cp);
 
     
     // ---------- QD TREE ---------- //
-    QDTree qd = QDTree(workload_filters, workload_projections, _metadata, min_leaf_size);
+    QDTree qd = QDTree(workload_filters, workload_queries, workload_weights, workload_projections, metadata, min_leaf_size);
 
     if(_verbose){
         std::cout << qd.root->print() << std::endl;
@@ -748,30 +1572,34 @@ void Dataframe::optimize(std::string partition_column, int min_leaf_size){
     st = arrow::compute::CallFunction("array_filter", {tuples_not_included, tuples_not_included});
     assert(st.ValueOrDie().make_array()->length()==0);
 
-    remove_index("qdTree");
+    remove_index(metadata, "qdTree");
     json qd_index = qdTree_metadata_file(qd, table);
     
     // write qd index metadata file
-    std::ofstream o2(_data_directory+"/qd_index.json");
-    o2 << std::setw(2) << qd_index << std::endl;
+    write_index_file(qd_index, _data_directory+"/qd_index.json");
 
     // update metadata
     json metadata_indexes_qd = metadata_qdTree_index(qd);
-    _metadata["indexes"].push_back(metadata_indexes_qd);
-
-    // read in file, replace table metadata
-    std::ifstream f("../data/metadata.json");
-    json metadata_json = json::parse(f);
-    for(auto& table: metadata_json["tables"]){
-        if(table["name"]==_table_name){
-            table = _metadata;
-            break;
-        }
-    } 
+    metadata_indexes_qd["workloadSummary"] = summary.report();
+    metadata["indexes"].push_back(metadata_indexes_qd);
+
+    // read in file, replace the indexes of the table. Under the metadata lock, a concurrent compaction
+    // of the workload log is not lost
+    {
+        FileLock metadata_lock(WorkloadLog::metadata_lock_path());
+        std::ifstream f("../data/metadata.json");
+        json metadata_json = json::parse(f);
+        for(auto& table: metadata_json["tables"]){
+            if(table["name"]==_table_name){
+                table["indexes"] = metadata["indexes"];
+                break;
+            }
+        } 
 
-    // write out updated metadata
-    std::ofstream o3("../data/metadata.json");
-    o3 << std::setw(2) << metadata_json << std::endl;
+        // write out updated metadata
+        WorkloadLog::write_metadata(metadata_json);
+    }
+    Catalog::instance().invalidate();
 }
 
 }
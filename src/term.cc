@@ -0,0 +1,157 @@
+#include "term.h"
+#include "expression.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace SDC{
+
+Term Term::col(std::string column){
+    Term term;
+    term.type = termType::column_term;
+    term.value = column;
+    return term;
+}
+
+Term Term::constant(std::string constant){
+    Term term;
+    term.type = termType::constant_term;
+    term.value = constant;
+    term.number = std::stod(constant);
+    return term;
+}
+
+static Term make_term(termType type, const Term& lhs, const Term& rhs){
+    Term term;
+    term.type = type;
+    term.operands = {lhs, rhs};
+    return term;
+}
+
+Term operator+(const Term& lhs, const Term& rhs){
+    return make_term(termType::add, lhs, rhs);
+}
+
+Term operator-(const Term& lhs, const Term& rhs){
+    return make_term(termType::subtract, lhs, rhs);
+}
+
+Term operator*(const Term& lhs, const Term& rhs){
+    return make_term(termType::multiply, lhs, rhs);
+}
+
+Term operator/(const Term& lhs, const Term& rhs){
+    return make_term(termType::divide, lhs, rhs);
+}
+
+std::string Term::to_string() const {
+    const char* symbols[] = {"", "", "+", "-", "*", "/"};
+    if(operands.empty()){
+        return value;
+    }
+    return "(" + operands[0].to_string() + symbols[type] + operands[1].to_string() + ")";
+}
+
+void Term::columns(std::vector<std::string>& result) const {
+    if(type==termType::column_term){
+        result.push_back(value);
+    }
+    for(const auto& operand: operands){
+        operand.columns(result);
+    }
+}
+
+int Term::num_operations() const {
+    int result = operands.empty() ? 0 : 1;
+    for(const auto& operand: operands){
+        result += operand.num_operations();
+    }
+    return result;
+}
+
+arrow::Result<arrow::Datum> Term::evaluate(const std::shared_ptr<arrow::Table>& table, int i, const std::shared_ptr<arrow::Array>& selection) const {
+    switch(type){
+        case termType::column_term:{
+            arrow::Datum chunk = table->GetColumnByName(value)->chunk(i);
+            if(selection!=nullptr){
+                return arrow::compute::Take(chunk, selection);
+            }
+            return chunk;
+        }
+        case termType::constant_term:{
+            return arrow::Datum(number);
+        }
+        default:{
+            const char* functions[] = {"", "", "add", "subtract", "multiply", "divide"};
+            ARROW_ASSIGN_OR_RAISE(arrow::Datum lhs, operands[0].evaluate(table, i, selection));
+            ARROW_ASSIGN_OR_RAISE(arrow::Datum rhs, operands[1].evaluate(table, i, selection));
+            // integer division would truncate (and fail on zero)
+            if(type==termType::divide && arrow::is_integer(lhs.type()->id())){
+                ARROW_ASSIGN_OR_RAISE(lhs, arrow::compute::Cast(lhs, arrow::float64()));
+            }
+            return arrow::compute::CallFunction(functions[type], {lhs, rhs});
+        }
+    }
+}
+
+Bounds Term::bounds(const BlockRanges& ranges) const {
+    Bounds result;
+    switch(type){
+        case termType::column_term:{
+            // exclusive bounds of double ranges are widened to inclusive ones, bounds of string ranges are ignored
+            for(size_t r=0; r<ranges.size(); r++){
+                if(ranges.column(r)!=value){
+                    continue;
+                }
+                BlockRange range = ranges[r];
+                if(range.type==dataType::string){
+                    continue;
+                }
+                if(range.has_min){
+                    result.min = std::max(result.min, value_to_double(range.min));
+                }
+                if(range.has_max){
+                    result.max = std::min(result.max, value_to_double(range.max));
+                }
+            }
+            return result;
+        }
+        case termType::constant_term:{
+            result.min = number;
+            result.max = number;
+            return result;
+        }
+        default:{
+            Bounds lhs = operands[0].bounds(ranges);
+            Bounds rhs = operands[1].bounds(ranges);
+            std::vector<double> candidates;
+            if(type==termType::add){
+                candidates = {lhs.min+rhs.min, lhs.max+rhs.max};
+            }
+            else if(type==termType::subtract){
+                candidates = {lhs.min-rhs.max, lhs.max-rhs.min};
+            }
+            else if(type==termType::multiply){
+                candidates = {lhs.min*rhs.min, lhs.min*rhs.max, lhs.max*rhs.min, lhs.max*rhs.max};
+            }
+            else{
+                // a divisor range containing zero can produce any value
+                if(rhs.min<=0 && rhs.max>=0){
+                    return result;
+                }
+                candidates = {lhs.min/rhs.min, lhs.min/rhs.max, lhs.max/rhs.min, lhs.max/rhs.max};
+            }
+            // undefined combinations of infinite bounds (e.g. inf-inf, 0*inf) leave the term unbounded
+            for(double candidate: candidates){
+                if(std::isnan(candidate)){
+                    return Bounds();
+                }
+            }
+            result.min = *std::min_element(candidates.begin(), candidates.end());
+            result.max = *std::max_element(candidates.begin(), candidates.end());
+            return result;
+        }
+    }
+}
+
+}
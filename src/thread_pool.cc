@@ -0,0 +1,143 @@
+#include "thread_pool.h"
+
+#include <cstdlib>
+#include <string>
+#include <chrono>
+#include <exception>
+#include <algorithm>
+
+namespace SDC{
+
+ThreadPool::ThreadPool(size_t num_threads)
+:pending(0), next_queue(0), stop(false){
+    for(size_t i=0; i<num_threads; i++){
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for(size_t i=0; i<num_threads; i++){
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for(auto& worker: workers){
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance(){
+    static ThreadPool pool([](){
+        const char* env = std::getenv("SDC_NUM_THREADS");
+        if(env!=nullptr && std::stoi(env)>0){
+            return size_t(std::stoi(env));
+        }
+        return std::max(size_t(1), size_t(std::thread::hardware_concurrency()));
+    }());
+    return pool;
+}
+
+// take a task from the front of the own queue, otherwise steal from the back of another queue
+bool ThreadPool::run_task(size_t queue_id){
+    for(size_t k=0; k<queues.size(); k++){
+        TaskQueue& queue = *queues[(queue_id+k)%queues.size()];
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(queue.tasks.empty()){
+                continue;
+            }
+            if(k==0){
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            else{
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+        }
+        pending--;
+        task();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t id){
+    while(true){
+        if(run_task(id)){
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait(lock, [this](){ return stop || pending>0; });
+        if(stop && pending==0){
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& task){
+    if(n==0){
+        return;
+    }
+    if(n==1 || workers.empty()){
+        for(size_t i=0; i<n; i++){
+            task(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> remaining(n);
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::exception_ptr exception;
+
+    // counted before the tasks are visible, a worker taking one must not decrement pending below zero
+    pending += n;
+
+    // distribute morsels round robin over the worker queues
+    size_t first_queue = next_queue++;
+    for(size_t i=0; i<n; i++){
+        TaskQueue& queue = *queues[(first_queue+i)%queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back([&, i](){
+            std::exception_ptr task_exception;
+            try{
+                task(i);
+            }
+            catch(...){
+                task_exception = std::current_exception();
+            }
+            // decrement under the lock, so the caller cannot return while this task still uses its state
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if(task_exception){
+                exception = task_exception;
+            }
+            if(--remaining==0){
+                done.notify_all();
+            }
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake.notify_all();
+
+    // help out until all tasks of this call are done
+    while(remaining>0){
+        if(!run_task(first_queue%queues.size())){
+            std::unique_lock<std::mutex> lock(done_mutex);
+            done.wait_for(lock, std::chrono::milliseconds(1), [&remaining](){ return remaining==0; });
+        }
+    }
+    // wait for the last task to release done_mutex
+    std::lock_guard<std::mutex> lock(done_mutex);
+    if(exception){
+        std::rethrow_exception(exception);
+    }
+}
+
+}
@@ -1,5 +1,8 @@
 #include "types.h"
 
+#include <limits>
+#include <arrow/compute/api.h>
+
 namespace SDC{
 
 std::string dataType_to_string(dataType d){
@@ -10,6 +13,21 @@ std::string dataType_to_string(dataType d){
         case dataType::double_:{
             return "double";
         }
+        case dataType::timestamp:{
+            return "timestamp";
+        }
+        case dataType::date:{
+            return "date";
+        }
+        case dataType::string:{
+            return "string";
+        }
+        case dataType::int32:{
+            return "int32";
+        }
+        case dataType::int8:{
+            return "int8";
+        }
         default: return "";
     }
 }
@@ -21,10 +39,117 @@ dataType string_to_dataType(std::string d){
     else if(d=="double"){
         return dataType::double_;
     }
+    else if(d=="timestamp"){
+        return dataType::timestamp;
+    }
+    else if(d=="date"){
+        return dataType::date;
+    }
+    else if(d=="string"){
+        return dataType::string;
+    }
+    else if(d=="int32"){
+        return dataType::int32;
+    }
+    else if(d=="int8"){
+        return dataType::int8;
+    }
     else{
         std::cout << "string to datatype error: " + d << std::endl;
         return dataType::int64;
     }
 }
 
-}
\ No newline at end of file
+dataType column_dataType(const std::string& d){
+    // the metadata names 64 bit integers "int64", index ranges "int"
+    if(d=="int64"){
+        return dataType::int64;
+    }
+    return string_to_dataType(d);
+}
+
+std::shared_ptr<arrow::DataType> dataType_to_arrow(dataType d){
+    switch(d){
+        case dataType::int64: return arrow::int64();
+        case dataType::timestamp: return arrow::timestamp(arrow::TimeUnit::MICRO);
+        case dataType::date: return arrow::date32();
+        case dataType::string: return arrow::utf8();
+        case dataType::int32: return arrow::int32();
+        case dataType::int8: return arrow::int8();
+        default: return arrow::float64();
+    }
+}
+
+bool is_integer_type(dataType d){
+    return d!=dataType::double_ && d!=dataType::string;
+}
+
+Value parse_value(dataType type, const std::string& value){
+    switch(type){
+        case dataType::double_:{
+            return Value(std::stod(value));
+        }
+        case dataType::string:{
+            return Value(value);
+        }
+        case dataType::timestamp:{
+            auto scalar = arrow::Scalar::Parse(arrow::timestamp(arrow::TimeUnit::MICRO), value).ValueOrDie();
+            return Value(int64_t(std::static_pointer_cast<arrow::TimestampScalar>(scalar)->value));
+        }
+        case dataType::date:{
+            auto scalar = arrow::Scalar::Parse(arrow::date32(), value).ValueOrDie();
+            return Value(int64_t(std::static_pointer_cast<arrow::Date32Scalar>(scalar)->value));
+        }
+        default:{
+            return Value(int64_t(std::stoll(value)));
+        }
+    }
+}
+
+std::shared_ptr<arrow::Scalar> value_to_scalar(dataType type, const Value& value){
+    // scalars of the column type avoid casting the column, constants out of its range are compared as int64
+    if(type==dataType::int32 || type==dataType::int8){
+        int64_t integer = std::get<int64_t>(value);
+        int64_t limit = type==dataType::int32 ? std::numeric_limits<int32_t>::max() : std::numeric_limits<int8_t>::max();
+        if(integer>limit || integer<-limit-1){
+            type = dataType::int64;
+        }
+    }
+    switch(type){
+        case dataType::double_: return arrow::MakeScalar<double>(std::get<double>(value));
+        case dataType::string: return std::make_shared<arrow::StringScalar>(std::get<std::string>(value));
+        case dataType::timestamp: return std::make_shared<arrow::TimestampScalar>(std::get<int64_t>(value), arrow::timestamp(arrow::TimeUnit::MICRO));
+        case dataType::date: return std::make_shared<arrow::Date32Scalar>(int32_t(std::get<int64_t>(value)));
+        case dataType::int32: return arrow::MakeScalar<int32_t>(int32_t(std::get<int64_t>(value)));
+        case dataType::int8: return arrow::MakeScalar<int8_t>(int8_t(std::get<int64_t>(value)));
+        default: return arrow::MakeScalar<int64_t>(std::get<int64_t>(value));
+    }
+}
+
+double value_to_double(const Value& value){
+    switch(value.index()){
+        case 0: return double(std::get<int64_t>(value));
+        case 1: return std::get<double>(value);
+        default: return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+arrow::Result<arrow::Datum> decode_dictionary(const arrow::Datum& values){
+    if(values.type()->id()!=arrow::Type::DICTIONARY){
+        return values;
+    }
+    auto dictionary_type = std::static_pointer_cast<arrow::DictionaryType>(values.type());
+    return arrow::compute::Cast(values, dictionary_type->value_type());
+}
+
+arrow::Result<arrow::Datum> evaluate_encoded(const arrow::Datum& values, const std::function<arrow::Result<arrow::Datum>(const arrow::Datum&)>& predicate){
+    if(values.type()->id()!=arrow::Type::DICTIONARY){
+        return predicate(values);
+    }
+    auto dictionary_array = std::static_pointer_cast<arrow::DictionaryArray>(values.make_array());
+    ARROW_ASSIGN_OR_RAISE(arrow::Datum dictionary_result, predicate(dictionary_array->dictionary()));
+    // null indices stay null, as for a comparison on the decoded values
+    return arrow::compute::Take(dictionary_result, dictionary_array->indices());
+}
+
+}
@@ -0,0 +1,437 @@
+#include "workload_log.h"
+#include "mapped_file.h"
+
+#include <fstream>
+#include <sstream>
+#include <cassert>
+#include <cerrno>
+#include <iomanip>
+#include <iostream>
+#include <filesystem>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+namespace SDC{
+
+
+// background compaction, joined before the next compaction and at exit
+struct BackgroundCompaction {
+    std::mutex mutex;
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    ~BackgroundCompaction(){
+        if(thread.joinable()){
+            thread.join();
+        }
+    }
+};
+static BackgroundCompaction background;
+
+// single thread running deferred records in order, drained and joined at exit. The queue is bounded,
+// a full queue blocks the pushing query until the recorder catches up
+struct DeferredRecorder {
+    static constexpr size_t max_tasks = 64;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::condition_variable space;
+    std::deque<std::function<void()>> tasks;
+    bool busy = false;
+    bool stop = false;
+    std::thread thread;
+
+    DeferredRecorder(){
+        thread = std::thread([this](){
+            std::unique_lock<std::mutex> lock(mutex);
+            while(true){
+                wake.wait(lock, [this](){ return stop || !tasks.empty(); });
+                if(tasks.empty()){
+                    return;
+                }
+                std::function<void()> task = std::move(tasks.front());
+                tasks.pop_front();
+                space.notify_one();
+                busy = true;
+                lock.unlock();
+                task();
+                lock.lock();
+                busy = false;
+                if(tasks.empty()){
+                    idle.notify_all();
+                }
+            }
+        });
+    }
+
+    ~DeferredRecorder(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+
+    void push(std::function<void()> task){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            space.wait(lock, [this](){ return tasks.size()<max_tasks; });
+            tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    void wait(){
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this](){ return tasks.empty() && !busy; });
+    }
+};
+
+// records waiting to be written, per log. Appending threads wait for the batch their records are in,
+// the first one becomes the leader and writes the whole batch
+struct GroupCommit {
+    struct Log {
+        std::string lock_path;
+        std::string records;
+    };
+    std::mutex mutex;
+    std::condition_variable committed;
+    std::map<std::string, Log> pending;
+    // size of each log after the last committed batch
+    std::map<std::string, uintmax_t> log_bytes;
+    uint64_t next_batch = 0;
+    uint64_t committed_batches = 0;
+    bool writing = false;
+};
+static GroupCommit group_commit;
+
+// query shapes whose boolean masks are scheduled on the recorder and not yet appended, as (log path, query id)
+struct PendingMasks {
+    std::mutex mutex;
+    std::set<std::pair<std::string, std::string>> queries;
+};
+static PendingMasks pending_masks;
+
+FileLock::FileLock(const std::string& path, bool shared)
+:_fd(open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)){
+    assert(_fd>=0);
+    int st;
+    while((st = flock(_fd, shared ? LOCK_SH : LOCK_EX))!=0 && errno==EINTR){
+    }
+    assert(st==0);
+}
+
+FileLock::~FileLock(){
+    // closing the descriptor releases the lock
+    close(_fd);
+}
+
+std::mutex& WorkloadLog::file_mutex(){
+    static std::mutex mutex;
+    return mutex;
+}
+
+// constructed after the file mutex, so that the recorder is drained before the mutex is destroyed
+static DeferredRecorder& deferred_recorder(){
+    WorkloadLog::file_mutex();
+    static DeferredRecorder recorder;
+    return recorder;
+}
+
+WorkloadLog::WorkloadLog(const std::string& table_name, const std::string& data_directory)
+:_table_name(table_name), _log_path(data_directory+"/workload.log"), _compacting_path(data_directory+"/workload.log.compacting"),
+_lock_path(data_directory+"/workload.log.lock"){}
+
+void WorkloadLog::append(const json& record){
+    std::vector<uint8_t> bytes = json::to_msgpack(record);
+    uint32_t size = bytes.size();
+    uintmax_t log_bytes;
+    {
+        std::unique_lock<std::mutex> lock(group_commit.mutex);
+        GroupCommit::Log& pending = group_commit.pending[_log_path];
+        pending.lock_path = _lock_path;
+        pending.records.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        pending.records.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        uint64_t batch = group_commit.next_batch;
+        while(group_commit.committed_batches<=batch){
+            if(group_commit.writing){
+                group_commit.committed.wait(lock);
+                continue;
+            }
+            // leader: the batch is closed, later records go to the next one
+            group_commit.writing = true;
+            std::map<std::string, GroupCommit::Log> logs = std::move(group_commit.pending);
+            group_commit.pending.clear();
+            group_commit.next_batch++;
+            lock.unlock();
+            std::map<std::string, uintmax_t> written_bytes;
+            {
+                std::lock_guard<std::mutex> file_lock(file_mutex());
+                for(const auto& [log_path, log]: logs){
+                    // appends wait while a compaction renames the log away
+                    FileLock log_lock(log.lock_path);
+                    int fd = open(log_path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+                    bool ok = fd>=0;
+                    size_t written = 0;
+                    while(ok && written<log.records.size()){
+                        ssize_t n = write(fd, log.records.data()+written, log.records.size()-written);
+                        if(n<0 && errno!=EINTR){
+                            ok = false;
+                        }
+                        written += n>0 ? n : 0;
+                    }
+                    // the batch is durable before its appending threads return
+                    ok = ok && fsync(fd)==0;
+                    if(!ok){
+                        std::cout << "workload log " << log_path << " could not be appended" << std::endl;
+                    }
+                    if(fd>=0){
+                        written_bytes[log_path] = lseek(fd, 0, SEEK_END);
+                        close(fd);
+                    }
+                }
+            }
+            lock.lock();
+            for(const auto& [log_path, size]: written_bytes){
+                group_commit.log_bytes[log_path] = size;
+            }
+            group_commit.committed_batches = group_commit.next_batch;
+            group_commit.writing = false;
+            group_commit.committed.notify_all();
+        }
+        log_bytes = group_commit.log_bytes[_log_path];
+    }
+    if(log_bytes<compaction_bytes || background.running.exchange(true)){
+        return;
+    }
+    std::lock_guard<std::mutex> lock(background.mutex);
+    if(background.thread.joinable()){
+        background.thread.join();
+    }
+    background.thread = std::thread([table_name=_table_name, log_path=_log_path, compacting_path=_compacting_path, lock_path=_lock_path](){
+        compact_files(table_name, log_path, compacting_path, lock_path);
+        background.running = false;
+    });
+}
+
+bool WorkloadLog::append_masks_deferred(const std::string& query_id, std::function<json()> task){
+    {
+        std::lock_guard<std::mutex> lock(pending_masks.mutex);
+        if(!pending_masks.queries.emplace(_log_path, query_id).second){
+            return false;
+        }
+    }
+    deferred_recorder().push([log=*this, query_id, task=std::move(task)]() mutable {
+        json record = task();
+        if(!record.is_null()){
+            log.append(record);
+        }
+        // the appended record marks the masks as recorded from now on
+        std::lock_guard<std::mutex> lock(pending_masks.mutex);
+        pending_masks.queries.erase({log._log_path, query_id});
+    });
+    return true;
+}
+
+bool WorkloadLog::masks_pending(const std::string& query_id) const {
+    std::lock_guard<std::mutex> lock(pending_masks.mutex);
+    return pending_masks.queries.count({_log_path, query_id})>0;
+}
+
+void WorkloadLog::flush(){
+    deferred_recorder().wait();
+}
+
+void WorkloadLog::compact(){
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(background.mutex);
+        if(background.thread.joinable()){
+            background.thread.join();
+        }
+    }
+    compact_files(_table_name, _log_path, _compacting_path, _lock_path);
+}
+
+Workload::Workload(const json& queries)
+:_queries(queries.is_null() ? json::array() : queries){
+    for(size_t q=0; q<_queries.size(); q++){
+        add_to_index(q);
+    }
+}
+
+void Workload::add_to_index(size_t position){
+    const json& query = _queries[position];
+    _query_positions.emplace(query["queryID"], position);
+    for(const auto& filter: query["filters"]){
+        std::string key = filter_key(filter["column"], filter["operator"], filter["constantOrColumn"], filter["isCol"]);
+        _filter_statistics.emplace(key, std::make_pair(filter["trueCount"].get<int64_t>(), filter["falseCount"].get<int64_t>()));
+    }
+}
+
+void Workload::apply(const json& record){
+    auto it = _query_positions.find(record["queryID"]);
+    if(it!=_query_positions.end() && record.contains("booleanMasks")){
+        const json& boolean_masks = record["booleanMasks"];
+        for(auto& filter: _queries[it->second]["filters"]){
+            std::string key = filter_key(filter["column"], filter["operator"], filter["constantOrColumn"], filter["isCol"]);
+            if(boolean_masks.contains(key)){
+                filter["booleanMask"] = boolean_masks[key];
+            }
+        }
+        return;
+    }
+    if(it!=_query_positions.end()){
+        json& query = _queries[it->second];
+        int executionCount = query["executionCount"];
+        query["executionCount"] = ++executionCount;
+        add_execution_day(query, record);
+        return;
+    }
+    // a repeated query whose first execution was never logged carries no workload entry
+    if(record.contains("filters")){
+        json query = record;
+        query.erase("executedAt");
+        add_execution_day(query, record);
+        _queries.push_back(query);
+        add_to_index(_queries.size()-1);
+    }
+}
+
+// executions per day since epoch, so that optimize can apply any decay and window
+void Workload::add_execution_day(json& query, const json& record){
+    if(!record.contains("executedAt")){
+        return;
+    }
+    std::string day = std::to_string(record["executedAt"].get<int64_t>()/86400);
+    json& execution_days = query["executionDays"];
+    int64_t count = execution_days.contains(day) ? execution_days[day].get<int64_t>() : 0;
+    execution_days[day] = count + 1;
+}
+
+double Workload::weight(const json& query, int64_t now, double half_life, double window){
+    int64_t today = now/86400;
+    auto decay = [today, half_life](int64_t day){
+        return half_life>0 ? std::pow(0.5, std::max<int64_t>(today-day, 0)/half_life) : 1.0;
+    };
+    double weight = 0;
+    int64_t timestamped = 0;
+    int64_t oldest_day = today;
+    json execution_days = query.value("executionDays", json::object());
+    for(const auto& [day_string, count]: execution_days.items()){
+        int64_t day = std::stoll(day_string);
+        timestamped += count.get<int64_t>();
+        oldest_day = std::min(oldest_day, day);
+        if(window>0 && today-day>window){
+            continue;
+        }
+        weight += count.get<int64_t>()*decay(day);
+    }
+    int64_t untimestamped = query["executionCount"].get<int64_t>() - timestamped;
+    if(untimestamped>0 && (window<=0 || today-oldest_day<=window)){
+        weight += untimestamped*decay(oldest_day);
+    }
+    return weight;
+}
+
+bool Workload::contains(const std::string& query_id) const {
+    return _query_positions.find(query_id)!=_query_positions.end();
+}
+
+const json* Workload::query(const std::string& query_id) const {
+    auto it = _query_positions.find(query_id);
+    return it!=_query_positions.end() ? &_queries[it->second] : nullptr;
+}
+
+bool Workload::filter_statistics(const std::string& filter_key, int64_t& true_count, int64_t& false_count) const {
+    auto it = _filter_statistics.find(filter_key);
+    if(it==_filter_statistics.end()){
+        return false;
+    }
+    true_count = it->second.first;
+    false_count = it->second.second;
+    return true;
+}
+
+std::string Workload::filter_key(const std::string& column, const std::string& operator_, const std::string& constant_or_column, bool is_col){
+    return column + '\x1f' + operator_ + '\x1f' + constant_or_column + '\x1f' + (is_col ? "1" : "0");
+}
+
+// applies the complete records after offset, a record torn by a crash ends the log.
+// Returns the offset after the last complete record.
+uint64_t WorkloadLog::read_records(const std::string& path, Workload& workload, uint64_t offset){
+    std::ifstream in_file(path, std::ios::binary);
+    in_file.seekg(offset);
+    uint32_t size;
+    std::vector<uint8_t> bytes;
+    while(in_file.read(reinterpret_cast<char*>(&size), sizeof(size))){
+        bytes.resize(size);
+        if(!in_file.read(reinterpret_cast<char*>(bytes.data()), size)){
+            break;
+        }
+        workload.apply(json::from_msgpack(bytes));
+        offset += sizeof(size) + size;
+    }
+    return offset;
+}
+
+// a crash leaves either the old or the complete new metadata.json
+bool WorkloadLog::write_metadata(const json& metadata_json){
+    std::ostringstream o;
+    o << std::setw(2) << metadata_json << std::endl;
+    std::string contents = o.str();
+    if(!write_file_atomically("../data/metadata.json", {contents})){
+        std::cout << "../data/metadata.json could not be written" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the log is renamed away under the log lock so appends continue into a fresh log while the
+// compacted metadata is written, the new metadata.json is swapped in with a rename.
+// The metadata lock is held throughout, compactions of several processes run one after another
+void WorkloadLog::compact_files(const std::string& table_name, const std::string& log_path, const std::string& compacting_path, const std::string& lock_path){
+    FileLock metadata_lock(metadata_lock_path());
+    {
+        std::lock_guard<std::mutex> lock(file_mutex());
+        FileLock log_lock(lock_path);
+        // a compacting log left behind by an interrupted compaction is folded in first
+        if(!std::filesystem::exists(compacting_path)){
+            if(!std::filesystem::exists(log_path)){
+                return;
+            }
+            std::filesystem::rename(log_path, compacting_path);
+        }
+    }
+
+    std::ifstream f("../data/metadata.json");
+    json metadata_json = json::parse(f);
+    for(auto& table: metadata_json["tables"]){
+        if(table["name"]==table_name){
+            Workload workload(table["workload"]);
+            read_records(compacting_path, workload);
+            table["workload"] = workload.queries();
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(file_mutex());
+    // a compacting log which could not be folded in is folded in by the next compaction
+    if(write_metadata(metadata_json)){
+        std::filesystem::remove(compacting_path);
+    }
+}
+
+}
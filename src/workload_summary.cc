@@ -0,0 +1,235 @@
+#include "workload_summary.h"
+#include "workload_log.h"
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cassert>
+
+namespace SDC{
+
+struct DistinctFilter {
+    json filter;
+    double selectivity;
+    // summed weight of the queries using the filter
+    double weight;
+    // distinct filter replacing this one, -1 if it is dropped
+    int representative;
+    // member of a range cluster without boolean masks, optimize has no cut for it and it counts as dropped
+    bool maskless_cluster = false;
+};
+
+// < and <= as well as > and >= bound a column from the same side
+static std::string operator_direction(const std::string& operator_){
+    if(operator_=="<" || operator_=="<="){
+        return "<";
+    }
+    if(operator_==">" || operator_==">="){
+        return ">";
+    }
+    return operator_;
+}
+
+// last member of each contiguous cluster, a cluster spans at most width in selectivity
+static std::vector<size_t> cluster_splits(const std::vector<DistinctFilter>& filters, const std::vector<size_t>& members, double width){
+    std::vector<size_t> splits;
+    double begin = filters[members[0]].selectivity;
+    for(size_t m=1; m<members.size(); m++){
+        if(filters[members[m]].selectivity-begin>width){
+            splits.push_back(m-1);
+            begin = filters[members[m]].selectivity;
+        }
+    }
+    splits.push_back(members.size()-1);
+    return splits;
+}
+
+// contiguous clusters by selectivity with the smallest maximum width, found by a binary search over the width.
+// The representative is the filter closest to the weighted mean selectivity of its cluster, filters with a
+// boolean mask are preferred as cut candidates
+static void cluster_ranges(std::vector<DistinctFilter>& filters, std::vector<size_t> members, size_t num_clusters){
+    std::stable_sort(members.begin(), members.end(), [&filters](size_t a, size_t b){
+        return filters[a].selectivity<filters[b].selectivity;
+    });
+    double low = 0;
+    double high = filters[members.back()].selectivity-filters[members[0]].selectivity;
+    for(int i=0; i<50 && high-low>1e-9; i++){
+        double width = (low+high)/2;
+        if(cluster_splits(filters, members, width).size()<=num_clusters){
+            high = width;
+        }
+        else{
+            low = width;
+        }
+    }
+    std::vector<size_t> splits = cluster_splits(filters, members, high);
+
+    size_t begin = 0;
+    for(size_t split: splits){
+        double weight = 0;
+        double weighted_selectivity = 0;
+        bool has_mask = false;
+        for(size_t m=begin; m<=split; m++){
+            weight += filters[members[m]].weight;
+            weighted_selectivity += filters[members[m]].weight*filters[members[m]].selectivity;
+            has_mask |= filters[members[m]].filter.contains("booleanMask");
+        }
+        double mean = weighted_selectivity/weight;
+        int representative = -1;
+        for(size_t m=begin; m<=split; m++){
+            const DistinctFilter& filter = filters[members[m]];
+            if(has_mask && !filter.filter.contains("booleanMask")){
+                continue;
+            }
+            if(representative<0 || std::abs(filter.selectivity-mean)<std::abs(filters[representative].selectivity-mean)){
+                representative = members[m];
+            }
+        }
+        for(size_t m=begin; m<=split; m++){
+            filters[members[m]].representative = representative;
+            filters[members[m]].maskless_cluster = !has_mask;
+        }
+        begin = split+1;
+    }
+}
+
+// filters without an order between their constants, the heaviest are kept
+static void keep_heaviest(std::vector<DistinctFilter>& filters, std::vector<size_t> members, size_t num_kept){
+    std::stable_sort(members.begin(), members.end(), [&filters](size_t a, size_t b){
+        return filters[a].weight>filters[b].weight;
+    });
+    for(size_t m=num_kept; m<members.size(); m++){
+        filters[members[m]].representative = -1;
+    }
+}
+
+WorkloadSummary::WorkloadSummary(const json& workload, const std::vector<double>& weights, size_t max_filters, size_t max_queries){
+    assert(workload.size()==weights.size());
+
+    // distinct filters in the order of their first use
+    std::vector<DistinctFilter> filters;
+    std::unordered_map<std::string, size_t> positions;
+    std::vector<std::vector<size_t>> query_filters(workload.size());
+    double total_weight = 0;
+    double filter_weight = 0;
+    for(size_t q=0; q<workload.size(); q++){
+        total_weight += weights[q];
+        for(const auto& metadata_filter: workload[q]["filters"]){
+            std::string key = Workload::filter_key(metadata_filter["column"], metadata_filter["operator"], metadata_filter["constantOrColumn"], metadata_filter["isCol"]);
+            auto [it, inserted] = positions.emplace(key, filters.size());
+            if(inserted){
+                double true_count = metadata_filter["trueCount"];
+                double false_count = metadata_filter["falseCount"];
+                double selectivity = true_count+false_count>0 ? true_count/(true_count+false_count) : 0.5;
+                filters.push_back(DistinctFilter{metadata_filter, selectivity, 0, int(it->second)});
+            }
+            if(std::find(query_filters[q].begin(), query_filters[q].end(), it->second)==query_filters[q].end()){
+                query_filters[q].push_back(it->second);
+                filters[it->second].weight += weights[q];
+                filter_weight += weights[q];
+            }
+        }
+    }
+
+    // the budget of filters is shared between the groups by their weight
+    if(filters.size()>max_filters){
+        std::map<std::string, std::vector<size_t>> groups;
+        for(size_t i=0; i<filters.size(); i++){
+            const json& filter = filters[i].filter;
+            std::string group = std::string(filter["column"]) + '\x1f' + operator_direction(filter["operator"]) + '\x1f' + (filter["isCol"] ? "1" : "0");
+            groups[group].push_back(i);
+        }
+        for(const auto& [group, members]: groups){
+            double group_weight = 0;
+            for(size_t i: members){
+                group_weight += filters[i].weight;
+            }
+            size_t budget = std::max<size_t>(1, size_t(max_filters*group_weight/filter_weight));
+            if(members.size()<=budget){
+                continue;
+            }
+            const json& filter = filters[members[0]].filter;
+            std::string direction = operator_direction(filter["operator"]);
+            if(!filter["isCol"] && (direction=="<" || direction==">")){
+                cluster_ranges(filters, members, budget);
+            }
+            else{
+                keep_heaviest(filters, members, budget);
+            }
+        }
+    }
+
+    // queries with the same representative filters are merged
+    double error_sum = 0;
+    double error_weight = 0;
+    double max_error = 0;
+    std::map<std::vector<size_t>, size_t> merged_queries;
+    for(size_t q=0; q<workload.size(); q++){
+        std::vector<size_t> representatives;
+        for(size_t i: query_filters[q]){
+            const DistinctFilter& filter = filters[i];
+            bool dropped = filter.representative<0 || filter.maskless_cluster;
+            double error = dropped ? 1-filter.selectivity : std::abs(filter.selectivity-filters[filter.representative].selectivity);
+            error_sum += weights[q]*error;
+            error_weight += weights[q];
+            max_error = std::max(max_error, error);
+            if(filter.representative>=0 && std::find(representatives.begin(), representatives.end(), filter.representative)==representatives.end()){
+                representatives.push_back(filter.representative);
+            }
+        }
+        std::vector<size_t> key = representatives;
+        std::sort(key.begin(), key.end());
+        auto [it, inserted] = merged_queries.emplace(key, _queries.size());
+        if(inserted){
+            Query query{{}, 0};
+            for(size_t i: representatives){
+                query.filters.push_back(filters[i].filter);
+            }
+            _queries.push_back(query);
+        }
+        _queries[it->second].weight += weights[q];
+    }
+
+    // the heaviest queries are kept in their order
+    double dropped_weight = 0;
+    if(_queries.size()>max_queries){
+        std::vector<size_t> order(_queries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b){
+            return _queries[a].weight>_queries[b].weight;
+        });
+        std::vector<bool> is_kept(_queries.size(), false);
+        for(size_t k=0; k<max_queries; k++){
+            is_kept[order[k]] = true;
+        }
+        std::vector<Query> kept_queries;
+        for(size_t q=0; q<_queries.size(); q++){
+            if(is_kept[q]){
+                kept_queries.push_back(std::move(_queries[q]));
+            }
+            else{
+                dropped_weight += _queries[q].weight;
+            }
+        }
+        _queries = std::move(kept_queries);
+    }
+
+    std::set<std::string> summarized_filters;
+    for(const auto& query: _queries){
+        for(const auto& filter: query.filters){
+            summarized_filters.insert(Workload::filter_key(filter["column"], filter["operator"], filter["constantOrColumn"], filter["isCol"]));
+        }
+    }
+    _report["queries"] = workload.size();
+    _report["summarizedQueries"] = _queries.size();
+    _report["filters"] = filters.size();
+    _report["summarizedFilters"] = summarized_filters.size();
+    _report["meanRowError"] = error_weight>0 ? error_sum/error_weight : 0;
+    _report["maxRowError"] = max_error;
+    _report["droppedQueryWeight"] = total_weight>0 ? dropped_weight/total_weight : 0;
+}
+
+}
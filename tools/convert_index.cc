@@ -0,0 +1,44 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+#include "binary_index.h"
+
+// converts JSON block indexes (qd_index.json, cp_index.json, primary_index.json) to the binary
+// index format, which is read instead of the JSON file as long as it is not older than it.
+// usage: convert_index <index.json>...
+int main(int argc, char** argv) {
+  if(argc<2){
+    std::cout << "usage: convert_index <index.json>..." << std::endl;
+    return 1;
+  }
+  for(int i=1; i<argc; i++){
+    std::string json_path = argv[i];
+    std::ifstream f(json_path);
+    if(!f){
+      std::cout << "cannot open " << json_path << std::endl;
+      return 1;
+    }
+    json index = json::parse(f);
+    std::string binary_path = SDC::BinaryIndex::binary_path(json_path);
+    SDC::BinaryIndex::write(index, binary_path);
+
+    // read back, the binary index has to describe the same blocks
+    std::shared_ptr<const SDC::BinaryIndex> binary = SDC::BinaryIndex::open(binary_path);
+    if(binary==nullptr || binary->num_blocks()!=index["dataBlocks"].size()){
+      std::cout << "conversion of " << json_path << " failed" << std::endl;
+      return 1;
+    }
+    for(size_t b=0; b<binary->num_blocks(); b++){
+      if(binary->ranges_json(b)!=index["dataBlocks"][b].value("ranges", json::array())){
+        std::cout << "ranges of block " << b << " of " << json_path << " differ after conversion" << std::endl;
+        return 1;
+      }
+    }
+    std::cout << json_path << " -> " << binary_path << " (" << binary->num_blocks() << " blocks)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <filesystem>
+
+#include "nlohmann/json.hpp"
+using json = nlohmann::json;
+
+#include "binary_index.h"
+#include "catalog.h"
+#include "expression.h"
+
+// open-plus-prune latency of a JSON and a binary block index with num_blocks qd tree like blocks,
+// each bounded on a double and an int column. The index is opened through the catalog and pruned over
+// its block ranges like a query does, keeping the blocks which may contain fare_amount > 100.
+// usage: index_benchmark [num_blocks] [directory]
+int main(int argc, char** argv) {
+  size_t num_blocks = argc>1 ? std::stoul(argv[1]) : 100000;
+  std::string directory = argc>2 ? argv[2] : ".";
+  std::string json_path = directory+"/benchmark_index.json";
+
+  json index;
+  index["table"] = "NYCtaxi";
+  index["indexType"] = "qdTree";
+  index["dataBlocks"] = json::array();
+  for(size_t b=0; b<num_blocks; b++){
+    json block;
+    block["filePath"] = "../data/NYCtaxi/qdTree/data_block_"+std::to_string(b)+".parquet";
+    block["numRows"] = 10000;
+    block["ranges"].push_back({{"column", "fare_amount"}, {"colDataType", "double"}, {"min", std::to_string(b*0.01)},
+        {"minInclusive", true}, {"max", std::to_string((b+1)*0.01)}, {"maxInclusive", false}});
+    block["ranges"].push_back({{"column", "VendorID"}, {"colDataType", "int"}, {"min", std::to_string(b%2)},
+        {"minInclusive", true}, {"max", ""}, {"maxInclusive", false}});
+    index["dataBlocks"].push_back(block);
+  }
+  std::ofstream o(json_path);
+  o << std::setw(2) << index << std::endl;
+  o.close();
+  std::filesystem::remove(SDC::BinaryIndex::binary_path(json_path));
+  SDC::IndexMetadata metadata_index({{"type", "qdTree"}, {"filePath", json_path}});
+
+  SDC::Value constant = 100.0;
+  auto open_and_prune = [&metadata_index, &constant](){
+    std::shared_ptr<const SDC::PreparedIndex> prepared = SDC::Catalog::instance().index(metadata_index);
+    size_t relevant = 0;
+    for(size_t b=0; b<prepared->num_blocks(); b++){
+      SDC::BlockRanges ranges = prepared->block_ranges(b);
+      bool is_relevant = true;
+      for(size_t r=0; r<ranges.size() && is_relevant; r++){
+        is_relevant = ranges.column(r)!="fare_amount" || ranges[r].compare(">", constant)!=SDC::rangeMatch::never;
+      }
+      relevant += is_relevant;
+    }
+    return relevant;
+  };
+
+  // without a binary index the catalog parses the JSON index
+  auto begin = std::chrono::high_resolution_clock::now();
+  size_t json_relevant = open_and_prune();
+  auto end = std::chrono::high_resolution_clock::now();
+  std::cout << "json:   " << std::chrono::duration<double>(end-begin).count() << " seconds, " << json_relevant << " of " << num_blocks << " blocks relevant" << std::endl;
+
+  // a binary index at least as new as the JSON index is mapped and pruned in place
+  SDC::BinaryIndex::write(index, SDC::BinaryIndex::binary_path(json_path));
+  SDC::Catalog::instance().invalidate();
+  begin = std::chrono::high_resolution_clock::now();
+  size_t binary_relevant = open_and_prune();
+  end = std::chrono::high_resolution_clock::now();
+  std::cout << "binary: " << std::chrono::duration<double>(end-begin).count() << " seconds, " << binary_relevant << " of " << num_blocks << " blocks relevant" << std::endl;
+  return json_relevant==binary_relevant ? 0 : 1;
+}